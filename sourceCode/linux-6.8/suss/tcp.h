@@ -405,10 +405,14 @@ struct tcp_sock {
 
 	/* suss start block     */
 	u8      suss_state      :4,     // This flag indicates the current state in which SUSS is operating.
-		suss_unused     :4;
+		suss_nocap      :1,     // The congestion control runs the cap (tcp_suss_cap) or ends slow start itself
+		suss_log        :1,     // The flow is one SUSS runs on (or would with suss=1), is logged and has tp->suss
+		suss_unused     :2;
 	u32	suss_limit;             // Maximum of cwnd in the current RTT (see Fig. 7 in the paper)
 	u64	suss_pacing_start_ns;   // Starting time of the pacing period
 	u64	suss_rate;              // Sending rate in the pacing period
+	u32	suss_flow_size;         // Expected size of the flow in bytes, see tcp_suss_set_flow_size() (0 means unknown)
+	struct tcp_suss *suss;          // The rest of the state of SUSS, see <net/tcp_suss.h>
 	u32	snd_isn;                // Initial sequence number (is used for monitoring)
 	u8	suss_msg_id;            // Message id (is used for monitoring)
 	/* suss end     block   */
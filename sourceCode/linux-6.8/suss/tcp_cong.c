@@ -18,6 +18,7 @@
 #include <net/tcp.h>
 #include <trace/events/tcp.h>
 #include <linux/random.h> /*	SUSS line - B1	*/
+#include <net/tcp_suss.h> /*	SUSS line - B3	*/
 
 static DEFINE_SPINLOCK(tcp_cong_list_lock);
 static LIST_HEAD(tcp_cong_list);
@@ -245,11 +246,20 @@ void tcp_init_congestion_control(struct sock *sk)
 	get_random_bytes(&tp->suss_msg_id, sizeof(tp->suss_msg_id));
 	printk(KERN_INFO "SUSSmsg %s starts sending data. Follow id=%u for Sport=%u", icsk->icsk_ca_ops->name, tp->suss_msg_id, inet_sk(sk)->inet_sport);
 	tp->snd_isn = tp->snd_una;
+	tp->suss_state = 10;
+	tp->suss_log = 0;
 	/* suss end block		*/
 
 	tcp_sk(sk)->prior_ssthresh = 0;
 	if (icsk->icsk_ca_ops->init)
 		icsk->icsk_ca_ops->init(sk);
+	/* suss start block - B3	*/
+	/* Reno and the congestion controls built on it (e.g., DCTCP) use SUSS
+	 * through tcp_reno_cong_avoid(); the others call tcp_suss_init() in their
+	 * init if they use it.	*/
+	if (icsk->icsk_ca_ops->cong_avoid == tcp_reno_cong_avoid)
+		tcp_suss_init(sk);
+	/* suss end block		*/
 	if (tcp_ca_needs_ecn(sk))
 		INET_ECN_xmit(sk);
 	else
@@ -283,6 +293,7 @@ void tcp_cleanup_congestion_control(struct sock *sk)
 
 	if (icsk->icsk_ca_ops->release)
 		icsk->icsk_ca_ops->release(sk);
+	tcp_suss_release(sk);	/*	SUSS line - B3	*/
 	bpf_module_put(icsk->icsk_ca_ops, icsk->icsk_ca_ops->owner);
 }
 
@@ -506,6 +517,8 @@ __bpf_kfunc void tcp_reno_cong_avoid(struct sock *sk, u32 ack, u32 acked)
 {
 	struct tcp_sock *tp = tcp_sk(sk);
 
+	tcp_suss_cong_avoid(sk, ack, acked);	/*	SUSS line - B3	*/
+
 	if (!tcp_is_cwnd_limited(sk))
 		return;
 
@@ -30,18 +30,8 @@
 #include <linux/module.h>
 #include <linux/math64.h>
 #include <net/tcp.h>
-
-/* suss start block - E1        */
-static int suss = 0;
-module_param(suss, int, 0644);
-MODULE_PARM_DESC(suss, "0 means suss is inactive");
-static int suss_max = 3;
-module_param(suss_max, int, 0644);
-MODULE_PARM_DESC(suss_max, "max of times the growth factor can be > 2");
-static int suss_kmax = 1;
-module_param(suss_kmax, int, 0644);
-MODULE_PARM_DESC(suss_kmax, "max of the number of RTTs over which the exponential growth can be projected to continue");
-/* suss end block	        */
+#include <net/tcp_suss.h>	/* suss line - E4	*/
+#include <net/netns/generic.h>	/* suss line - E23	*/
 
 #define BICTCP_BETA_SCALE    1024	/* Scale factor beta calculation
 					 * max_cwnd = snd_cwnd * beta
@@ -58,10 +48,11 @@ MODULE_PARM_DESC(suss_kmax, "max of the number of RTTs over which the exponentia
 #define HYSTART_DELAY_MAX	(16000U)	/* 16 ms */
 #define HYSTART_DELAY_THRESH(x)	clamp(x, HYSTART_DELAY_MIN, HYSTART_DELAY_MAX)
 
-/* suss start block - E2	*/
-#define BW_SCALE 24
-#define BW_UNIT (1 << BW_SCALE)
-#define SUSS_SCALE 10
+/* suss start block - E16	*/
+/* HyStart++ (RFC 9406) with Conservative Slow Start (CSS) */
+#define HYSTART_PLUS		0x4
+#define HYSTART_CSS_GROWTH_DIVISOR	4
+#define HYSTART_CSS_ROUNDS	5
 /* suss end block		*/
 
 static int fast_convergence __read_mostly = 1;
@@ -94,7 +85,9 @@ module_param(hystart, int, 0644);
 MODULE_PARM_DESC(hystart, "turn on/off hybrid slow start algorithm");
 module_param(hystart_detect, int, 0644);
 MODULE_PARM_DESC(hystart_detect, "hybrid slow start detection mechanisms"
-		 " 1: packet-train 2: delay 3: both packet-train and delay");
+		 " 1: packet-train 2: delay 3: both packet-train and delay"
+		 " 4: HyStart++ (replaces the others and SUSS's cap),"
+		 " see also net.ipv4.tcp_cubic_hystart_plus");
 module_param(hystart_low_window, int, 0644);
 MODULE_PARM_DESC(hystart_low_window, "lower bound cwnd for hybrid slow start");
 module_param(hystart_ack_delta_us, int, 0644);
@@ -120,24 +113,88 @@ struct bictcp {
 	u32	end_seq;	/* end_seq of the round */
 	u32	last_ack;	/* last time when the ACK spacing is close */
 	u32	curr_rtt;	/* the minimum rtt of current round */
-/* suss start block - E3	*/
-        u32     suss_head_seq;          /* head of the blue part of the data train              */
-        u32     suss_tail_seq;          /* tail of the blue part of the data train              */
-        u32     suss_round_start_us;    /* the start time of the current round                  */
-        u64     suss_round_no   :5,     /* the current round number                             */
-                suss_gf         :1,     /* cwnd is quadrupled when suss_gf is one               */
-                suss_is_blue    :2,     /* It is 0 if the received ACK is red                   */
-                suss_flag       :1,     /* suss_flag=1 means stop EG when cwnd reaches suss_cap */
-                suss_cap        :14,    /* it is used in HyStart to stop EG when suss_flag=1    */
-                suss_r_minupdate:5,     /* in which round minRTT was updated                    */
-                suss_blue_cnt   :12,    /* number of received blue ACKs in the current round    */
-                suss_perv_delta_t_bat:18,/* how long did it take to receive the blue ACK train
-                                           in the pervious round                                */
-                suss_num_of_jump:3,     /* number of pacing period                              */
-                suss_unused     :3;
+/* suss start block - E17	*/
+	u32	hspp_last_rtt;	/* HyStart++: min rtt of the previous round */
+	u32	hspp_css_rtt;	/* HyStart++: min rtt when CSS was entered */
+	u8	hspp_css_rounds;/* HyStart++: rounds spent in CSS, 0 when not in CSS */
+	u8	hspp_on;	/* HyStart++ is used by this flow */
+	u8	hspp_jumps;	/* SUSS's jumps at the start of the round */
+	u8	hspp_gf;	/* SUSS could still jump when CSS was entered */
+	u8	hspp_jumped;	/* SUSS jumped in the previous round */
 /* suss end block		*/
 };
 
+/* suss start block - E23	*/
+/* HyStart++ can be selected per netns with net.ipv4.tcp_cubic_hystart_plus:
+ * -1 (default) follows hystart_detect, 0 turns it off and 1 turns it on.
+ */
+static unsigned int cubic_net_id __read_mostly;
+
+struct cubic_net {
+	int			hystart_plus;
+	struct ctl_table_header	*hdr;
+};
+
+static struct ctl_table cubic_net_table[] = {
+	{
+		.procname	= "tcp_cubic_hystart_plus",
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_NEG_ONE,
+		.extra2		= SYSCTL_ONE,
+	},
+	{ }
+};
+
+static int __net_init cubic_net_init(struct net *net)
+{
+	struct cubic_net *cn = net_generic(net, cubic_net_id);
+	struct ctl_table *table = cubic_net_table;
+
+	cn->hystart_plus = -1;
+	if (!net_eq(net, &init_net)) {
+		table = kmemdup(table, sizeof(cubic_net_table), GFP_KERNEL);
+		if (!table)
+			return -ENOMEM;
+	}
+	table[0].data = &cn->hystart_plus;
+	cn->hdr = register_net_sysctl_sz(net, "net/ipv4", table,
+					 ARRAY_SIZE(cubic_net_table));
+	if (!cn->hdr) {
+		if (table != cubic_net_table)
+			kfree(table);
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+static void __net_exit cubic_net_exit(struct net *net)
+{
+	struct cubic_net *cn = net_generic(net, cubic_net_id);
+	struct ctl_table *table = cn->hdr->ctl_table_arg;
+
+	unregister_net_sysctl_table(cn->hdr);
+	if (table != cubic_net_table)
+		kfree(table);
+}
+
+static struct pernet_operations cubic_net_ops = {
+	.init	= cubic_net_init,
+	.exit	= cubic_net_exit,
+	.id	= &cubic_net_id,
+	.size	= sizeof(struct cubic_net),
+};
+
+static bool hystart_plus_on(const struct sock *sk)
+{
+	const struct cubic_net *cn = net_generic(sock_net(sk), cubic_net_id);
+	int on = READ_ONCE(cn->hystart_plus);
+
+	return on < 0 ? !!(hystart_detect & HYSTART_PLUS) : on;
+}
+/* suss end block		*/
+
 static inline void bictcp_reset(struct bictcp *ca)
 {
 	memset(ca, 0, offsetof(struct bictcp, unused));
@@ -166,18 +223,16 @@ __bpf_kfunc static void cubictcp_init(struct sock *sk)
 
 	bictcp_reset(ca);
 /* suss start block - E4	*/
-	struct tcp_sock *tp = tcp_sk(sk);
-	ca->suss_num_of_jump = 0;
-	ca->suss_gf   = 1;
-	ca->suss_flag = 0;
-	ca->suss_cap  = 0;
-	ca->suss_round_no = 1;
-	ca->suss_head_seq = tp->snd_nxt;
-	ca->suss_tail_seq = tp->snd_nxt + (10 * tp->mss_cache) - 1;
-	if (suss && (sk->sk_pacing_status == SK_PACING_NONE) && (inet_sk(sk)->inet_sport==20480 || inet_sk(sk)->inet_dport==20480))
-	    tp->suss_state = 1;
-	else
-	    tp->suss_state = 10;
+	tcp_suss_init(sk);
+	/* HyStart runs the cap of SUSS where it detects the ACK train (block E8),
+	 * with its own thresholds; HyStart++ replaces both */
+	ca->hspp_on = hystart_plus_on(sk);
+	tcp_sk(sk)->suss_nocap = 1;
+	ca->hspp_last_rtt = ~0U;
+	ca->hspp_css_rounds = 0;
+	ca->hspp_jumps = 0;
+	ca->hspp_jumped = 0;
+	ca->hspp_gf = 0;
 /* suss end block       */
 	if (hystart)
 		bictcp_hystart_reset(sk);
@@ -368,166 +423,26 @@ tcp_friendliness:
 	ca->cnt = max(ca->cnt, 2U);
 }
 
-/* suss start block - E7	*/
-static u8 suss_speedup(struct sock *sk, u32 delta_t_bat)
-{
-    struct bictcp *ca = inet_csk_ca(sk);
-    struct tcp_sock *tp = tcp_sk(sk);
-
-    u8 value = 0;
-
-    if (ca->suss_round_no == 2) {
-	if (ca->delay_min > 10000 && delta_t_bat < (ca->delay_min >> 2)) {
-	    value = 1;
-	} else {
-	    tp->suss_state = 10; // Disable SUSS
-	}
-    } else {
-	u32 delta_t = delta_t_bat << (ca->suss_round_no - 2);
-	u32 perv_delta_t = ca->suss_perv_delta_t_bat << (ca->suss_round_no - 3);
-	u64 mu = div64_u64((u64)delta_t << SUSS_SCALE, (perv_delta_t << 1));
-	u64 temp = (mu * delta_t) >> (SUSS_SCALE - 1);
-
-	/* Condition 1 */
-	if ((temp <= ca->delay_min) && (ca->suss_round_no < (suss_max + 2))) {
-	    value = 1;
-	} else {
-	    value = 0;
-	}
-
-	/* Condition 2 */
-	if (value == 1) {
-	    u32 k = ca->suss_round_no - ca->suss_r_minupdate;
-	    u64 temp1 = (u64)(k + 1) * ca->curr_rtt;
-	    u64 temp2 = (u64)(ca->delay_min * (k + 1)) + ((ca->delay_min * k) >> 3);
-
-	    if (temp1 > temp2) {
-		value = 0;
-	    }
-	}
-
-	printk(KERN_INFO "SUSSmsg id=%u Growth factor measured. t=%u Sport=%u G=%u",
-	 tp->suss_msg_id, bictcp_clock_us(sk), inet_sk(sk)->inet_sport, 2 << value);
-    }
-
-    return value;
-}
-/* suss end block		*/
-
-/* suss start block - E11	*/
-__bpf_kfunc static void suss_measurements(struct sock *sk, u32 ack, u32 acked)
-{
-    struct tcp_sock *tp = tcp_sk(sk);
-    struct bictcp *ca = inet_csk_ca(sk);
-    u32 now = bictcp_clock_us(sk);
-
-    /* Is it the first red ACK */
-    if (ca->suss_is_blue == 2)
-	ca->suss_is_blue = 0;
-
-    /* If it is the head of an ACK train then
-    1) increase round counter    2) switch to ACK clocking mode  */
-    if (ack > ca->suss_head_seq) {
-	ca->suss_is_blue = 1;
-	ca->suss_blue_cnt = 0;
-	ca->suss_round_no ++;
-	ca->suss_round_start_us = now;
-	ca->suss_head_seq = tp->snd_nxt;
-	printk(KERN_INFO "SUSSmsg id=%u New round %u is started. t=%u Sport=%u c=%u i=%u",
-	 tp->suss_msg_id, ca->suss_round_no, now, inet_sk(sk)->inet_sport, tp->snd_cwnd, tcp_packets_in_flight(tp));
-
-	cmpxchg(&sk->sk_pacing_status, SK_PACING_NEEDED, SK_PACING_NONE);//swtich to ACK clocking mode
-	tp->suss_state = 1;
-    }
-
-    /* If this is the tail of the blue part of an ACK train: measure delta_t_bat and quadruple cwnd if all conditions are satisfied. */
-    if (ack > ca->suss_tail_seq) {
-	u64 rate, guard;
-	u32 temp, elapsed, blue_pkt, blue_ack, red_pkt, red_ack, delta_t_bat, pacing_duration;
-
-	elapsed = (now - ca->suss_round_start_us);
-	ca->suss_is_blue = 2;
-	blue_pkt = TCP_INIT_CWND << (ca->suss_round_no - 1);
-	blue_ack = blue_pkt >> 1;
-	ca->suss_tail_seq = ca->suss_head_seq + (blue_pkt * tp->mss_cache) - 1;
-
-	temp = ca->suss_blue_cnt << 1;
-	delta_t_bat= div64_long((u64) (blue_pkt * elapsed), temp);
-	printk(KERN_INFO "SUSSmsg id=%u Blue ACK train in round %u is received in %u us. t=%u Sport=%u dtB=%u c=%u i=%u",
-	 tp->suss_msg_id, ca->suss_round_no, elapsed, now, inet_sk(sk)->inet_sport, delta_t_bat, tp->snd_cwnd, tcp_packets_in_flight(tp));
-
-	if (ca->suss_gf == 1) {
-	    ca->suss_gf = suss_speedup(sk, delta_t_bat);
-	}
-
-	if (ca->suss_gf == 1) {
-	    ca->suss_perv_delta_t_bat = delta_t_bat;
-	    red_pkt = (blue_pkt << (ca->suss_round_no - 1)) - blue_pkt;
-	    red_ack = (blue_ack << (ca->suss_round_no - 2)) - blue_ack;
-	    tp->suss_limit = (tp->snd_cwnd + acked) + red_pkt - red_ack;
-	    pacing_duration = ca->delay_min - (ca->delay_min >> (ca->suss_round_no - 1));
-	    rate = div64_long((u64) (red_pkt * tp->mss_cache) * BW_UNIT, pacing_duration);
-	    rate *= USEC_PER_SEC;
-	    rate = rate >> BW_SCALE;
-	    tp->suss_rate = rate;
-
-	    temp = ca->delay_min - pacing_duration;
-	    if (temp > delta_t_bat) {
-		tp->suss_state = 2;
-		ca->suss_num_of_jump += 1;
-		guard = ((temp - delta_t_bat) >> 1) * NSEC_PER_USEC;
-		tp->suss_pacing_start_ns = tp->tcp_clock_cache + guard;
-		printk(KERN_INFO "SUSSmsg id=%u Total amount of %u packets is paced in %u microSec with rate %llu Bps starting from time %llu ns. t=%u Sport=%u limit=%u delta_t_bat=%u guard=%llu",
-		 tp->suss_msg_id, red_pkt, pacing_duration, rate, tp->suss_pacing_start_ns, now, inet_sk(sk)->inet_sport, tp->suss_limit, delta_t_bat, guard);
-	    } else {
-		tp->suss_state = 1;
-	    }
-	}
-    }
-
-    if (ca->suss_is_blue != 0) {
-	ca->suss_blue_cnt += acked;
-    }
-
-    if (ca->suss_is_blue == 0 && tp->suss_state == 2) {
-	tp->snd_cwnd -= acked;
-    }
-}
-/* suss end block	*/
-
 __bpf_kfunc static void cubictcp_cong_avoid(struct sock *sk, u32 ack, u32 acked)
 {
 	struct tcp_sock *tp = tcp_sk(sk);
 	struct bictcp *ca = inet_csk_ca(sk);
 
 /* suss start block - E6	*/
-	u32 una = tp->snd_una - tp->snd_isn;
-	u8  temp = 0;
-
-	if ((tp->suss_state > 2) && (tp->suss_state < 10) && (sk->sk_pacing_status == SK_PACING_NEEDED))
-		cmpxchg(&sk->sk_pacing_status, SK_PACING_NEEDED, SK_PACING_NONE); //swtich to clocking mode
-
-	if (tp->suss_state < 3 && ca->suss_flag == 0)
-		suss_measurements(sk, ack, acked);
-
-
-	if ((tp->suss_state < 3) && (ca->suss_round_no < (suss_max + ca->suss_num_of_jump)))
-		temp = (ca->suss_round_no + ca->suss_num_of_jump - 1);
-
-	tp->snd_wnd = max(tp->snd_wnd, ((10 * tp->mss_cache) << temp));
-
-	printk(KERN_INFO "SUSSmsg@ id=%u t=%llu Sport=%u c=%u i=%u a=%u "
-	"RTT=%u moRTT=%u minRTT=%u d=%u l=%u "
-	"tRnd=%u s=%u Bcnt=%u Rnd=%u ",
-	tp->suss_msg_id, tp->tcp_mstamp, inet_sk(sk)->inet_sport, tp->snd_cwnd, tcp_packets_in_flight(tp), acked,
-	(tp->srtt_us >> 3), ca->curr_rtt, ca->delay_min, una, tp->lost,
-	ca->round_start, tp->suss_state, ca->suss_blue_cnt, ca->suss_round_no);
+	tcp_suss_cong_avoid(sk, ack, acked);
 /* suss end block		*/
 
 	if (!tcp_is_cwnd_limited(sk))
 		return;
 
 	if (tcp_in_slow_start(tp)) {
+/* suss start block - E18	*/
+		if (ca->hspp_css_rounds) {
+			/* HyStart++ CSS: cwnd grows by acked/4 */
+			tcp_cong_avoid_ai(tp, HYSTART_CSS_GROWTH_DIVISOR, acked);
+			return;
+		}
+/* suss end block		*/
 		acked = tcp_slow_start(tp, acked);
 		if (!acked)
 			return;
@@ -556,8 +471,13 @@ __bpf_kfunc static u32 cubictcp_recalc_ssthresh(struct sock *sk)
 __bpf_kfunc static void cubictcp_state(struct sock *sk, u8 new_state)
 {
 	if (new_state == TCP_CA_Loss) {
+		struct bictcp *ca = inet_csk_ca(sk);	/* suss line - E15	*/
+
 		bictcp_reset(inet_csk_ca(sk));
 		bictcp_hystart_reset(sk);
+		ca->hspp_css_rounds = 0;		/* suss line - E21	*/
+		ca->hspp_last_rtt = ~0U;		/* suss line - E21	*/
+		ca->hspp_gf = 0;			/* suss line - E21	*/
 	}
 }
 
@@ -581,42 +501,87 @@ static u32 hystart_ack_delay(const struct sock *sk)
 		     div64_ul((u64)sk->sk_gso_max_size * 4 * USEC_PER_SEC, rate));
 }
 
-/* suss start block - E12	*/
-static void suss_cap(struct sock *sk)
+/* suss start block - E19	*/
+/* HyStart++ (RFC 9406). The min RTT of each round is compared with the one of
+ * the previous round instead of delay_min. An increase moves the flow to
+ * Conservative Slow Start (CSS) rather than ending slow start; CSS is left
+ * again if the RTT drops back below its baseline, and slow start ends after
+ * HYSTART_CSS_ROUNDS rounds in CSS.
+ * A round in which SUSS jumped grows cwnd by 4 rather than 2, like two rounds
+ * of slow start, so the RTT of the next round may grow twice as much before
+ * CSS is entered. SUSS does not jump while in CSS, so the CSS rounds are rounds
+ * of the usual growth. If the increase shows up while a jump is in flight and
+ * more than one jump was made, cwnd is rolled back to what is in flight, as
+ * for the other exits. If CSS turns out to be spurious, SUSS may jump again.
+ */
+static void hystart_plus_update(struct sock *sk, u32 delay)
 {
-    struct tcp_sock *tp = tcp_sk(sk);
-    struct bictcp *ca = inet_csk_ca(sk);
-    u32 threshold;
-    u32 now = bictcp_clock_us(sk);
-
-    u32 temp;
-    if (ca->suss_flag == 1 && tp->snd_cwnd > ca->suss_cap) {
-	ca->found = 1;
-	printk(KERN_INFO "SUSSmsg id=%u Stop exponential growth (type=3): t=%u Sport=%u cap=%u ssthresh=%u c=%u i=%u",
-	 tp->suss_msg_id, now, inet_sk(sk)->inet_sport, ca->suss_cap, tp->snd_ssthresh, tp->snd_cwnd, tcp_packets_in_flight(tp));
-	tp->suss_state = 3;
-	if (ca->suss_num_of_jump > 1) {
-	    tp->snd_cwnd = tcp_packets_in_flight(tp);
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct bictcp *ca = inet_csk_ca(sk);
+	u32 threshold;
+
+	if (after(tp->snd_una, ca->end_seq)) {
+		ca->hspp_last_rtt = ca->curr_rtt;
+		if (ca->hspp_css_rounds && ++ca->hspp_css_rounds > HYSTART_CSS_ROUNDS) {
+			ca->found = 1;
+			printk(KERN_INFO "SUSSmsg id=%u Stop exponential growth (type=4): t=%u Sport=%u roundStart=%u ssthresh=%u c=%u i=%u",
+			 tp->suss_msg_id, bictcp_clock_us(sk), inet_sk(sk)->inet_sport, ca->round_start, tp->snd_ssthresh, tp->snd_cwnd, tcp_packets_in_flight(tp));
+			if (tp->suss_state < 9)
+				tp->suss_state = 4;
+			NET_INC_STATS(sock_net(sk),
+				      LINUX_MIB_TCPHYSTARTDELAYDETECT);
+			NET_ADD_STATS(sock_net(sk),
+				      LINUX_MIB_TCPHYSTARTDELAYCWND,
+				      tcp_snd_cwnd(tp));
+			tp->snd_ssthresh = tcp_snd_cwnd(tp);
+			return;
+		}
+		bictcp_hystart_reset(sk);
+		ca->hspp_jumped = tcp_suss_jumps(tp) != ca->hspp_jumps;
+		ca->hspp_jumps = tcp_suss_jumps(tp);
 	}
 
-	tp->snd_ssthresh = tp->snd_cwnd;
-	return;
-    }
-
-    if (ca->suss_flag == 0 && tp->suss_state < 3 && ca->suss_is_blue != 0) {
-	if ((s32)(now - ca->last_ack) <= hystart_ack_delta_us) {
-	    ca->last_ack = now;
-	    threshold = ca->delay_min + hystart_ack_delay(sk);
-	    threshold >>= 1;
-	    temp = (now - ca->round_start) << ca->suss_num_of_jump;
-	    if (temp > threshold) {
-		ca->suss_flag = 1;
-		ca->suss_cap = tp->snd_cwnd + (ca->suss_blue_cnt * ((1 << ca->suss_num_of_jump) - 1));
-		printk(KERN_INFO "SUSSmsg id=%u Cap is set: t=%u Sport=%u cap=%u ssthresh=%u c=%u i=%u",
-		 tp->suss_msg_id, now, inet_sk(sk)->inet_sport, ca->suss_cap, tp->snd_ssthresh, tp->snd_cwnd, tcp_packets_in_flight(tp));
-	    }
+	if (tcp_snd_cwnd(tp) < hystart_low_window)
+		return;
+
+	if (ca->curr_rtt > delay)
+		ca->curr_rtt = delay;
+	if (ca->sample_cnt < HYSTART_MIN_SAMPLES) {
+		ca->sample_cnt++;
+		return;
+	}
+
+	if (ca->hspp_css_rounds) {
+		if (ca->curr_rtt < ca->hspp_css_rtt) {
+			ca->hspp_css_rounds = 0;	/* spurious, back to slow start */
+			if (ca->hspp_gf && tp->suss_state < 3)
+				tp->suss->gf = 1;
+			ca->hspp_gf = 0;
+			printk(KERN_INFO "SUSSmsg id=%u CSS is left. t=%u Sport=%u rtt=%u base=%u c=%u i=%u",
+			 tp->suss_msg_id, bictcp_clock_us(sk), inet_sk(sk)->inet_sport, ca->curr_rtt, ca->hspp_css_rtt, tp->snd_cwnd, tcp_packets_in_flight(tp));
+		}
+		return;
+	}
+
+	if (ca->hspp_last_rtt == ~0U)
+		return;
+
+	threshold = HYSTART_DELAY_THRESH(ca->hspp_last_rtt >> 3) << ca->hspp_jumped;
+	if (ca->curr_rtt >= ca->hspp_last_rtt + threshold) {
+		ca->hspp_css_rounds = 1;
+		ca->hspp_css_rtt = ca->curr_rtt;
+		if (tp->suss_log) {
+			ca->hspp_gf = tp->suss->gf;
+			tp->suss->gf = 0;
+		}
+		if (tp->suss_state == 2) {
+			tp->suss_state = 1;
+			if (tp->suss->num_of_jump > 1)
+				tp->snd_cwnd = tcp_packets_in_flight(tp);
+		}
+		printk(KERN_INFO "SUSSmsg id=%u CSS is entered. t=%u Sport=%u rtt=%u last=%u c=%u i=%u",
+		 tp->suss_msg_id, bictcp_clock_us(sk), inet_sk(sk)->inet_sport, ca->curr_rtt, ca->hspp_last_rtt, tp->snd_cwnd, tcp_packets_in_flight(tp));
 	}
-    }
 }
 /* suss end block		*/
 
@@ -626,6 +591,13 @@ static void hystart_update(struct sock *sk, u32 delay)
 	struct bictcp *ca = inet_csk_ca(sk);
 	u32 threshold;
 
+/* suss start block - E20	*/
+	if (ca->hspp_on) {
+		hystart_plus_update(sk, delay);
+		return;
+	}
+/* suss end block		*/
+
 	if (after(tp->snd_una, ca->end_seq))
 		bictcp_hystart_reset(sk);
 
@@ -636,7 +608,8 @@ static void hystart_update(struct sock *sk, u32 delay)
 	if (hystart_detect & HYSTART_ACK_TRAIN) {
 		u32 now = bictcp_clock_us(sk);
 /* suss start block - E8	*/
-		suss_cap(sk);
+		if (tcp_suss_cap(sk, delay, hystart_ack_delta_us))
+			ca->found = 1;
         	if (tp->suss_state == 10)
 /* suss end block       	*/
 
@@ -688,7 +661,7 @@ static void hystart_update(struct sock *sk, u32 delay)
 				 tp->suss_msg_id, bictcp_clock_us(sk), inet_sk(sk)->inet_sport, ca->round_start, tp->snd_ssthresh, tp->snd_cwnd, tcp_packets_in_flight(tp));
 				if (tp->suss_state < 9)	{
 					tp->suss_state = 4;
-					if (ca->suss_num_of_jump > 1)
+					if (tp->suss->num_of_jump > 1)
 					tp->snd_cwnd = tcp_packets_in_flight(tp);
 				}
 				/* suss end block		*/
@@ -723,10 +696,7 @@ __bpf_kfunc static void cubictcp_acked(struct sock *sk, const struct ack_sample
 
 	/* first time call or link delay decreases */
 	if (ca->delay_min == 0 || ca->delay_min > delay)
-	{	/* suss line - E5	*/
 		ca->delay_min = delay;
-		ca->suss_r_minupdate = ca->suss_round_no;	/* suss line - E5	*/
-	}	/* suss line - E5	*/
 
 	if (!ca->found && tcp_in_slow_start(tp) && hystart)
 		hystart_update(sk, delay);
@@ -799,12 +769,21 @@ static int __init cubictcp_register(void)
 	ret = register_btf_kfunc_id_set(BPF_PROG_TYPE_STRUCT_OPS, &tcp_cubic_kfunc_set);
 	if (ret < 0)
 		return ret;
-	return tcp_register_congestion_control(&cubictcp);
+/* suss start block - E24	*/
+	ret = register_pernet_subsys(&cubic_net_ops);
+	if (ret < 0)
+		return ret;
+	ret = tcp_register_congestion_control(&cubictcp);
+	if (ret < 0)
+		unregister_pernet_subsys(&cubic_net_ops);
+	return ret;
+/* suss end block		*/
 }
 
 static void __exit cubictcp_unregister(void)
 {
 	tcp_unregister_congestion_control(&cubictcp);
+	unregister_pernet_subsys(&cubic_net_ops);	/* suss line - E24	*/
 }
 
 module_init(cubictcp_register);
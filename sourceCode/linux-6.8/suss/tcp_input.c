@@ -80,6 +80,7 @@
 #include <linux/jump_label_ratelimit.h>
 #include <net/busy_poll.h>
 #include <net/mptcp.h>
+#include <net/tcp_suss.h>	/*	suss line - C4	*/
 
 int sysctl_tcp_max_orphans __read_mostly = NR_FILE;
 
@@ -963,7 +964,7 @@ static void tcp_update_pacing_rate(struct sock *sk)
 	 * without any lock. We want to make sure compiler wont store
 	 * intermediate values in this location.
 	 */
-	if(tp->suss_state != 2) /*	suss line - C1	*/
+	if(tp->suss_state != 2 && tp->suss_state != 6) /*	suss line - C1	*/
 	WRITE_ONCE(sk->sk_pacing_rate,
 		   min_t(u64, rate, READ_ONCE(sk->sk_max_pacing_rate)));
 }
@@ -2208,8 +2209,16 @@ void tcp_enter_loss(struct sock *sk)
 		tcp_init_undo(tp);
 	}
 	/* suss start block - C2	*/
-	if((tp->suss_state > 0 && tp->suss_state < 10) && tp->snd_cwnd < 40)
-	    tp->suss_state = 10;
+	tcp_suss_cwnd_reduction(sk);
+	/* SUSS paces back toward ssthresh after the RTO (state 5, see tcp_suss_enter_loss),
+	 * unless the RTO hit while it was already doing so (states 5 and 6) or the
+	 * window was below 40 packets (as in 5.19.10).	*/
+	if(tp->suss_state > 0 && tp->suss_state < 10) {
+	    if((tp->suss_state == 5) || (tp->suss_state == 6) || tp->snd_cwnd < 40)
+		tp->suss_state = 10;
+	    else
+		tp->suss_state = 5;
+	}
 	printk(KERN_INFO "SUSSmsg id=%u Entered loss state. t=%llu Sport=%u cwnd=%u inf=%u state=%u loss=%u tcp_in_slow_start=%u",
 	 tp->suss_msg_id, tp->tcp_mstamp, inet_sk(sk)->inet_sport, tp->snd_cwnd, tcp_packets_in_flight(tp), tp->suss_state, tp->lost, tcp_in_slow_start(tp));
 	/* suss end block - C2		*/
@@ -2228,6 +2237,7 @@ void tcp_enter_loss(struct sock *sk)
 				       reordering);
 
 	tcp_set_ca_state(sk, TCP_CA_Loss);
+	tcp_suss_enter_loss(sk);	/*	suss line - C6	*/
 	tp->high_seq = tp->snd_nxt;
 	tp->tlp_high_seq = 0;
 	tcp_ecn_queue_cwr(tp);
@@ -2690,6 +2700,7 @@ static void tcp_init_cwnd_reduction(struct sock *sk)
 		tp->snd_cwnd = tcp_packets_in_flight(tp);
 	    tp->suss_state = 9;
 	}
+	tcp_suss_cwnd_reduction(sk);
 	/* suss end block - C3		*/
 	tp->snd_ssthresh = inet_csk(sk)->icsk_ca_ops->ssthresh(sk);
 	tcp_ecn_queue_cwr(tp);
@@ -3499,6 +3510,7 @@ static int tcp_clean_rtx_queue(struct sock *sk, const struct sk_buff *ack_skb,
 		flag |= FLAG_SET_XMIT_TIMER;  /* set TLP or RTO timer */
 	}
 
+	tcp_suss_acked(sk, sack->rate->rtt_us);	/*	suss line - C4	*/
 	if (icsk->icsk_ca_ops->pkts_acked) {
 		struct ack_sample sample = { .pkts_acked = pkts_acked,
 					     .rtt_us = sack->rate->rtt_us };
@@ -3847,6 +3859,7 @@ static inline void tcp_in_ack_event(struct sock *sk, u32 flags)
 {
 	const struct inet_connection_sock *icsk = inet_csk(sk);
 
+	tcp_suss_in_ack_event(sk, flags);	/*	suss line - C5	*/
 	if (icsk->icsk_ca_ops->in_ack_event)
 		icsk->icsk_ca_ops->in_ack_event(sk, flags);
 }
@@ -39,6 +39,7 @@
 
 #include <net/tcp.h>
 #include <net/mptcp.h>
+#include <net/tcp_suss.h>	/*	suss line - D4	*/
 
 #include <linux/compiler.h>
 #include <linux/gfp.h>
@@ -1263,6 +1264,21 @@ static void tcp_update_skb_after_send(struct sock *sk, struct sk_buff *skb,
 		}
 	}
 	list_move_tail(&skb->tcp_tsorted_anchor, &tp->tsorted_sent_queue);
+/* suss start block - D4	*/
+	/* Record the departures of the red train (see suss_pacing_feedback). The
+	time is read now: skb_mstamp_ns is when the packet was due, which says
+	nothing about how late it actually left. */
+	if ((tp->suss_state == 2) && (sk->sk_pacing_status == SK_PACING_NEEDED)) {
+	    struct tcp_suss *ss = tp->suss;
+	    u64 now_ns = tcp_clock_ns();
+
+	    if (!ss->red_pkts)
+		ss->red_first_ns = now_ns;
+	    ss->red_last_ns = now_ns;
+	    ss->red_last_segs = tcp_skb_pcount(skb);
+	    ss->red_pkts += tcp_skb_pcount(skb);
+	}
+/* suss end block - D4		*/
 /* suss start block - D1	*/
 	if((tp->snd_cwnd < tp->suss_limit) && (tp->suss_state == 2) &&
 	(tp->snd_cwnd <= (tcp_packets_in_flight(tp)+tcp_skb_pcount(skb))))//sometime sending is delayed in Ack clocking mode (e.g., because of small queue check)
@@ -2622,6 +2638,15 @@ static bool tcp_small_queue_check(struct sock *sk, const struct sk_buff *skb,
 	if (sk->sk_pacing_status == SK_PACING_NONE)
 		limit = min_t(unsigned long, limit,
 			      READ_ONCE(sock_net(sk)->ipv4.sysctl_tcp_limit_output_bytes));
+/* suss start block - D3	*/
+	/* During a SUSS pacing period (and the ACK clocked blue burst that comes
+	 * right before it), the budget is sized from the planned rate so that the
+	 * red train is not throttled here while sk_pacing_rate still holds the
+	 * ACK clocking rate.	*/
+	if ((tcp_sk(sk)->suss_state == 2) || (tcp_sk(sk)->suss_state == 6))
+		limit = max_t(unsigned long, limit,
+			      tcp_sk(sk)->suss_rate >> READ_ONCE(sk->sk_pacing_shift));
+/* suss end block - D3		*/
 	limit <<= factor;
 
 	if (static_branch_unlikely(&tcp_tx_delay_enabled) &&
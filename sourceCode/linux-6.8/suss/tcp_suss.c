@@ -0,0 +1,1128 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * SUSS: Speeding Up Slow Start
+ *
+ * SUSS splits the data train of each round of slow start into a blue part,
+ * which is ACK clocked as in standard slow start, and a red part, which is
+ * paced out in the idle time of the round. From the ACK train of the blue part
+ * it decides whether cwnd can grow by a factor of 4 rather than 2 in the next
+ * round (a jump), and it plans the pacing of the red part accordingly.
+ *
+ * This file holds everything that does not depend on the congestion control:
+ * round tracking, blue/red classification, the speedup decision, the pacing
+ * planner, the cap, the per destination table, the pacing budget and the
+ * recovery after an RTO. The hooks and the state of a flow (struct tcp_suss)
+ * are declared in <net/tcp_suss.h>.
+ */
+
+#include <linux/module.h>
+#include <linux/math64.h>
+#include <linux/slab.h>
+#include <net/tcp.h>
+#include <net/netns/generic.h>
+#include <net/inetpeer.h>
+#include <net/tcp_suss.h>
+
+static int suss = 0;
+module_param(suss, int, 0644);
+MODULE_PARM_DESC(suss, "0 means suss is inactive");
+static int suss_max = 3;
+module_param(suss_max, int, 0644);
+MODULE_PARM_DESC(suss_max, "max of times the growth factor can be > 2");
+static int suss_max_cap = 5;
+module_param(suss_max_cap, int, 0644);
+MODULE_PARM_DESC(suss_max_cap, "hard cap on the per-path adaptation of suss_max");
+static int suss_kmax = 1;
+module_param(suss_kmax, int, 0644);
+MODULE_PARM_DESC(suss_kmax, "max of the number of RTTs over which the exponential growth can be projected to continue");
+static int suss_rto = 1;
+module_param(suss_rto, int, 0644);
+MODULE_PARM_DESC(suss_rto, "1 means SUSS paces back toward ssthresh after an RTO");
+static int suss_gradient = 0;
+module_param(suss_gradient, int, 0644);
+MODULE_PARM_DESC(suss_gradient, "1 means the cap is set from the delay gradient of the blue trains of two rounds in a row (experimental)");
+static int suss_rtt_win = 10000;
+module_param(suss_rtt_win, int, 0644);
+MODULE_PARM_DESC(suss_rtt_win, "window (msec) of the min RTT filter used by SUSS");
+static int suss_stages = 1;
+module_param(suss_stages, int, 0644);
+MODULE_PARM_DESC(suss_stages, "number of paced stages of the red train in a round (1 means a single pacing period)");
+static int suss_budget = 0;
+module_param(suss_budget, int, 0644);
+MODULE_PARM_DESC(suss_budget, "budget (Mbit/s) for the sum of the red trains paced at a time in a netns (0 means no limit)");
+
+#define BW_SCALE 24
+#define BW_UNIT (1 << BW_SCALE)
+#define SUSS_SCALE 10
+#define SUSS_GRAD_XSHIFT 4				/* time unit of the delay gradient fit: 16 us	*/
+#define SUSS_GRAD_MIN_SAMPLES 8				/* samples before the gradient is used	*/
+#define SUSS_MAX_STAGES 8
+#define SUSS_MAX_JUMPS 7				/* suss_num_of_jump is 3 bits		*/
+#define SUSS_FAT_RTT 40000				/* paths with a longer min RTT (us) may get more jumps	*/
+#define SUSS_DST_BITS 8					/* size of the per destination cache	*/
+#define SUSS_DST_TTL (600 * HZ)
+#define SUSS_SEED_SLACK 1000				/* slack of a cached min RTT over the first sample (us)	*/
+#define SUSS_SEED_NONE 0				/* rtt_min holds an ACK sample, or nothing	*/
+#define SUSS_SEED_SYN 1					/* rtt_min holds the handshake RTT		*/
+#define SUSS_SEED_DST 2					/* rtt_min holds the min RTT of the destination	*/
+#define SUSS_GRAD_THRESH (1 << (SUSS_SCALE - 3))	/* cap when queueing delay grows 1 us per 8 us	*/
+#define SUSS_CAP_WINDOW 16				/* no cap below this cwnd, without HyStart (as hystart_low_window)	*/
+#define SUSS_ACK_DELTA_US 2000				/* spacing of the ACKs of a train, without HyStart (as hystart_ack_delta_us)	*/
+
+static inline u32 suss_clock_us(const struct sock *sk)
+{
+	return tcp_sk(sk)->tcp_mstamp;
+}
+
+/* The RTT reference of SUSS: the min RTT over the last suss_rtt_win msec, so that
+ * a route change that raises the base RTT is seen. Before the first ACK sample it
+ * is the seed (see tcp_suss_init), or the smoothed RTT without one. */
+static inline u32 suss_delay_min(const struct sock *sk)
+{
+	u32 rtt = minmax_get(&tcp_sk(sk)->suss->rtt_min);
+
+	return (rtt == ~0U) ? (tcp_sk(sk)->srtt_us >> 3) : rtt;
+}
+
+/* Per destination table of each netns, keyed by the peer address like
+ * tcp_metrics: the hash of the address picks the slot, the full address (and
+ * family) tells whether the slot holds the destination.
+ *
+ * It caches the number of jumps a flow may take (suss_max by default). A flow
+ * that leaves slow start by a loss after jumping caches one jump less for the
+ * next flows to the same destination; a flow that used all of its jumps and left
+ * slow start cleanly caches one more, up to suss_max_cap.
+ *
+ * It also coordinates the flows to the destination that are in SUSS slow start
+ * at the same time (parallel connections of a browser), which share one
+ * bottleneck (see suss_coord_split). A slot that is used by such flows is not
+ * given to another destination until they leave.
+ */
+struct suss_dst {
+	struct inetpeer_addr addr;	/* family 0 if the slot is free			*/
+	u8		jumps;		/* cached number of jumps, 0 if none		*/
+	u8		flows;		/* flows in SUSS slow start			*/
+	unsigned long	stamp;		/* when jumps was cached			*/
+	u32		rtt_min;	/* min of the RTT references of the flows	*/
+	unsigned long	rtt_stamp;	/* when rtt_min was updated			*/
+	u32		round_us;	/* start of the current shared round		*/
+	u32		ack_us;		/* sum of the ACK clocked trains of the next round	*/
+	u32		red_us;		/* sum of the red trains planned in the shared round	*/
+	u8		round_flows;	/* flows that planned in the shared round	*/
+};
+
+/* The state of SUSS that is shared by the flows of a netns: the destinations
+ * and the budget of the jumps (see suss_budget_admit). */
+static unsigned int suss_net_id __read_mostly;
+
+struct suss_net {
+	spinlock_t	dst_lock;	/* protects dst				*/
+	struct suss_dst	dst[1 << SUSS_DST_BITS];
+	atomic64_t	reserved;	/* sum of the rates (Bps) of the reserved red trains	*/
+};
+
+static int __net_init suss_net_init(struct net *net)
+{
+	struct suss_net *sn = net_generic(net, suss_net_id);
+
+	spin_lock_init(&sn->dst_lock);
+	return 0;
+}
+
+static struct pernet_operations suss_net_ops = {
+	.init	= suss_net_init,
+	.id	= &suss_net_id,
+	.size	= sizeof(struct suss_net),
+};
+
+static u32 suss_jumps_cap(void)
+{
+    return clamp(suss_max_cap, 1, SUSS_MAX_JUMPS);
+}
+
+/* Returns the entry of the destination of sk in sn, or NULL if there is none
+ * and the slot cannot be claimed. Called with sn->dst_lock held. */
+static struct suss_dst *suss_dst_get(struct suss_net *sn, const struct sock *sk, bool claim)
+{
+    struct inetpeer_addr addr;
+    struct suss_dst *d;
+    u32 hash;
+
+#if IS_ENABLED(CONFIG_IPV6)
+    if (sk->sk_family == AF_INET6 && !ipv6_addr_v4mapped(&sk->sk_v6_daddr)) {
+	inetpeer_set_addr_v6(&addr, &sk->sk_v6_daddr);
+	hash = ipv6_addr_hash(&sk->sk_v6_daddr);
+    } else
+#endif
+    {
+	inetpeer_set_addr_v4(&addr, sk->sk_daddr);
+	hash = (__force u32)sk->sk_daddr;
+    }
+
+    d = &sn->dst[hash_32(hash, SUSS_DST_BITS)];
+    if (d->addr.family && !inetpeer_addr_cmp(&d->addr, &addr))
+	return d;
+    if (!claim || d->flows)
+	return NULL;
+
+    memset(d, 0, sizeof(*d));
+    d->addr = addr;
+    d->rtt_min = ~0U;
+    return d;
+}
+
+static u8 suss_dst_jumps(const struct sock *sk)
+{
+    u32 jumps = clamp(suss_max, 0, SUSS_MAX_JUMPS);
+    struct suss_net *sn = net_generic(sock_net(sk), suss_net_id);
+    struct suss_dst *d;
+
+    spin_lock_bh(&sn->dst_lock);
+    d = suss_dst_get(sn, sk, false);
+    if (d && d->jumps && time_before(jiffies, d->stamp + SUSS_DST_TTL))
+	jumps = d->jumps;
+    spin_unlock_bh(&sn->dst_lock);
+
+    return min(jumps, suss_jumps_cap());
+}
+
+static void suss_dst_save(struct sock *sk, u32 jumps)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    struct suss_net *sn = net_generic(sock_net(sk), suss_net_id);
+    struct suss_dst *d;
+
+    ss->dst_saved = 1;
+    jumps = clamp(jumps, 1U, suss_jumps_cap());
+    spin_lock_bh(&sn->dst_lock);
+    d = suss_dst_get(sn, sk, true);
+    if (d) {
+	d->jumps = jumps;
+	d->stamp = jiffies;
+    }
+    spin_unlock_bh(&sn->dst_lock);
+    printk(KERN_INFO "SUSSmsg id=%u %u jumps are cached for the destination. t=%u Sport=%u used=%u allowed=%u",
+     tp->suss_msg_id, jumps, suss_clock_us(sk), inet_sk(sk)->inet_sport, ss->num_of_jump, ss->max_jumps);
+}
+
+/* A flow joins the flows to its destination when SUSS starts. If a parallel flow
+ * has a lower RTT reference, the flow starts from it (checked by the first ACK
+ * sample, see tcp_suss_acked). */
+static void suss_coord_join(struct sock *sk)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    struct suss_net *sn = net_generic(sock_net(sk), suss_net_id);
+    struct suss_dst *d;
+    u32 rtt = ~0U;
+
+    spin_lock_bh(&sn->dst_lock);
+    d = suss_dst_get(sn, sk, true);
+    if (d && d->flows < U8_MAX) {
+	d->flows++;
+	ss->coord = 1;
+	if (time_before(jiffies, d->rtt_stamp + msecs_to_jiffies(suss_rtt_win)))
+	    rtt = d->rtt_min;
+    }
+    spin_unlock_bh(&sn->dst_lock);
+
+    if (rtt < minmax_get(&ss->rtt_min)) {
+	minmax_reset(&ss->rtt_min, suss_clock_us(sk), rtt);
+	ss->seed = SUSS_SEED_DST;
+    }
+}
+
+static void suss_coord_leave(struct sock *sk)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    struct suss_net *sn = net_generic(sock_net(sk), suss_net_id);
+    struct suss_dst *d;
+
+    if (!ss->coord)
+	return;
+
+    ss->coord = 0;
+    spin_lock_bh(&sn->dst_lock);
+    d = suss_dst_get(sn, sk, false);
+    if (d && d->flows)
+	d->flows--;
+    spin_unlock_bh(&sn->dst_lock);
+}
+
+/* Parallel flows to one destination measure the same bottleneck, and each of
+ * them sees that its own blue train leaves room for a jump; the sum of their
+ * trains may not. The shared round lasts one min RTT. In it, every flow adds
+ * the ACK clocked train it sends in its next round (twice its blue train, i.e.,
+ * 4 delta_t_bat at the bottleneck), and the flows that have not reached their
+ * blue tail yet are taken to add as much. Every flow also adds the red train it
+ * plans, for the time its packets take at the bottleneck (2 delta_t_bat per
+ * blue_pkt), not for the time it is paced over. If the red train of a flow does
+ * not fit in what is left of the min RTT, it is scaled down to fill that only.
+ * The flows that reach their blue tail first get their red trains first, so
+ * the split favours them; it is still bounded in total.
+ */
+static u32 suss_coord_split(struct sock *sk, u32 red_pkt, u32 blue_pkt, u32 delta_t_bat, u32 delay_min)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    u32 now = suss_clock_us(sk);
+    u32 ack_us = delta_t_bat << 2;
+    u32 red_us = div_u64((u64)red_pkt * (delta_t_bat << 1), max(blue_pkt, 1U));
+    u32 flows = 0, busy = 0, scaled = red_pkt;
+    struct suss_net *sn = net_generic(sock_net(sk), suss_net_id);
+    struct suss_dst *d;
+
+    if (!ss->coord)
+	return red_pkt;
+
+    spin_lock_bh(&sn->dst_lock);
+    d = suss_dst_get(sn, sk, false);
+    if (d) {
+	if (now - d->round_us > delay_min) {
+	    d->round_us = now;
+	    d->ack_us = d->red_us = 0;
+	    d->round_flows = 0;
+	}
+	d->ack_us += ack_us;
+	if (d->round_flows < U8_MAX)
+	    d->round_flows++;
+	if (delay_min <= d->rtt_min || time_after_eq(jiffies, d->rtt_stamp + msecs_to_jiffies(suss_rtt_win))) {
+	    d->rtt_min = delay_min;
+	    d->rtt_stamp = jiffies;
+	}
+	flows = d->flows;
+	busy = d->ack_us + d->red_us + (flows - min_t(u32, flows, d->round_flows)) * ack_us;
+	if (flows > 1 && red_pkt && busy + red_us > delay_min)
+	    scaled = div_u64((u64)red_pkt * (delay_min - min(busy, delay_min)), max(red_us, 1U));
+	d->red_us += red_pkt ? div_u64((u64)red_us * scaled, red_pkt) : 0;
+    }
+    spin_unlock_bh(&sn->dst_lock);
+
+    if (scaled < red_pkt)
+	printk(KERN_INFO "SUSSmsg id=%u Jump is shared by %u flows: %u of %u packets. t=%u Sport=%u busy=%u red=%u",
+	 tp->suss_msg_id, flows, scaled, red_pkt, now, inet_sk(sk)->inet_sport, busy, red_us);
+
+    return scaled;
+}
+
+/* Admission of jumps per netns. When many connections start at once, the red
+ * trains paced at the same time can exceed what the host can send (local drops,
+ * TSQ throttling). A jump reserves its pacing rate from suss_budget before it is
+ * planned and returns it when its round ends. A jump gets what is left of the
+ * budget: its red train shrinks with it, and a flow that gets nothing continues
+ * with ACK clocking (growth factor 2) in this round.
+ */
+static u32 suss_budget_admit(struct sock *sk, u32 red_pkt)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    struct suss_net *sn = net_generic(sock_net(sk), suss_net_id);
+    s64 budget = (s64)suss_budget * (USEC_PER_SEC / 8);
+    s64 prev, grant;
+    u32 cut;
+
+    if (suss_budget <= 0 || !tp->suss_rate)
+	return red_pkt;
+
+    do {
+	prev = atomic64_read(&sn->reserved);
+	grant = min_t(s64, tp->suss_rate, budget - prev);
+	if (grant <= 0) {
+	    grant = 0;
+	    break;
+	}
+    } while (atomic64_cmpxchg(&sn->reserved, prev, prev + grant) != prev);
+
+    ss->resv = grant;
+    if (grant < tp->suss_rate) {
+	cut = red_pkt - div64_u64((u64)red_pkt * grant, tp->suss_rate);
+	printk(KERN_INFO "SUSSmsg id=%u Jump is admitted with rate %lld of %llu Bps: %u of %u packets. t=%u Sport=%u reserved=%lld",
+	 tp->suss_msg_id, grant, tp->suss_rate, red_pkt - cut, red_pkt, suss_clock_us(sk), inet_sk(sk)->inet_sport, prev);
+	red_pkt -= cut;
+	tp->suss_limit -= cut;
+	ss->red_plan = red_pkt;
+	ss->red_max = red_pkt;
+	tp->suss_rate = grant;
+    }
+
+    return red_pkt;
+}
+
+static void suss_budget_release(struct sock *sk)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    struct suss_net *sn;
+
+    if (!ss->resv)
+	return;
+
+    sn = net_generic(sock_net(sk), suss_net_id);
+    atomic64_sub(ss->resv, &sn->reserved);
+    ss->resv = 0;
+}
+
+static u8 suss_speedup(struct sock *sk, u32 delta_t_bat)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    u32 delay_min = suss_delay_min(sk);
+
+    u8 value = 0;
+
+    if (ss->round_no == 2) {
+	if (delay_min > 10000 && delta_t_bat < (delay_min >> 2)) {
+	    value = 1;
+	    /* A cached raise is only kept on long paths */
+	    if (delay_min < SUSS_FAT_RTT)
+		ss->max_jumps = min_t(u32, ss->max_jumps, max(suss_max, 0));
+	} else {
+	    tp->suss_state = 10; // Disable SUSS
+	}
+    } else {
+	u32 delta_t = delta_t_bat << (ss->round_no - 2);
+	u32 perv_delta_t = ss->perv_delta_t_bat << (ss->round_no - 3);
+	/* A blue train of the last round acked within the same microsecond gives
+	a zero perv_delta_t; it counts as 1 us. */
+	u64 mu = div64_u64((u64)delta_t << SUSS_SCALE, (u64)max(perv_delta_t, 1U) << 1);
+	u64 temp = (mu * delta_t) >> (SUSS_SCALE - 1);
+
+	/* On a long path, allow one more jump if the projected train would still
+	leave half of the RTT idle (i.e., the blue train is delivered at more than
+	twice the rate the next jump needs). */
+	if ((ss->round_no == ss->max_jumps + 2) && (ss->max_jumps < suss_jumps_cap()) &&
+	    (delay_min >= SUSS_FAT_RTT) && ((temp << 1) <= delay_min)) {
+	    ss->max_jumps++;
+	    printk(KERN_INFO "SUSSmsg id=%u Jumps are raised to %u. t=%u Sport=%u rate=%llu",
+	     tp->suss_msg_id, ss->max_jumps, suss_clock_us(sk), inet_sk(sk)->inet_sport,
+	     div64_u64((u64)(TCP_INIT_CWND << (ss->round_no - 1)) * tp->mss_cache * USEC_PER_SEC, (u64)max(delta_t_bat, 1U) << 1));
+	}
+
+	/* Condition 1 */
+	if ((temp <= delay_min) && (ss->round_no < (ss->max_jumps + 2))) {
+	    value = 1;
+	} else {
+	    value = 0;
+	}
+
+	/* Condition 2 */
+	if (value == 1) {
+	    u32 k = ss->round_no - ss->r_minupdate;
+	    u64 temp1 = (u64)(k + 1) * ss->rtt_round;
+	    u64 temp2 = (u64)(delay_min * (k + 1)) + ((delay_min * k) >> 3);
+
+	    if (temp1 > temp2) {
+		value = 0;
+	    }
+	}
+
+	printk(KERN_INFO "SUSSmsg id=%u Growth factor measured. t=%u Sport=%u G=%u",
+	 tp->suss_msg_id, suss_clock_us(sk), inet_sk(sk)->inet_sport, 2 << value);
+    }
+
+    return value;
+}
+
+/* Flow size hint: the number of bytes that the connection sends in total
+ * (counted from the ISN), or 0 if unknown. The owner of the socket (e.g., an
+ * in-kernel server that knows the size of the object) may give it at any time
+ * before the end of slow start. There is no socket option for it: that needs
+ * do_tcp_setsockopt() in tcp.c and a number in <uapi/linux/tcp.h>, which these
+ * sources do not change. */
+void tcp_suss_set_flow_size(struct sock *sk, u32 bytes)
+{
+    tcp_sk(sk)->suss_flow_size = bytes;
+}
+EXPORT_SYMBOL_GPL(tcp_suss_set_flow_size);
+
+/* Number of packets that are left to be sent, or U32_MAX if it is unknown.
+ * It comes from the flow size hint if the application gave one. Otherwise,
+ * the size is known once the whole object has been queued (i.e., a FIN is
+ * at the tail of the write queue, e.g., after sendfile() and close()). */
+static u32 suss_pkts_left(struct sock *sk)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct sk_buff *skb = tcp_write_queue_tail(sk);
+    u32 sent = tp->snd_nxt - tp->snd_isn;
+    u32 left;
+
+    if (tp->suss_flow_size)
+	left = (tp->suss_flow_size > sent) ? (tp->suss_flow_size - sent) : 0;
+    else if (skb && (TCP_SKB_CB(skb)->tcp_flags & TCPHDR_FIN))
+	left = tp->write_seq - tp->snd_nxt;
+    else
+	return U32_MAX;
+
+    return DIV_ROUND_UP(left, tp->mss_cache);
+}
+
+/* Number of packets that the receiver window lets SUSS send from now to the end
+ * of the round. The window is the one the receiver advertised; only its right
+ * edge moves, by the red packets that are still to be ACKed in this round. The
+ * window is not assumed to grow: receive buffer autotuning may lag behind, and
+ * SUSS used to force snd_wnd up instead, which sent more than the receiver could
+ * buffer. */
+static u32 suss_rwnd_pkts(struct sock *sk, u32 red_ack)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    u32 edge;
+
+    edge = tp->snd_una + (red_ack * tp->mss_cache) + tp->snd_wnd;
+    if (!after(edge, tp->snd_nxt))
+	return 0;
+    return (edge - tp->snd_nxt) / tp->mss_cache;
+}
+
+/* Compares the red train of the round that just ended with its plan. The
+ * departures are recorded in tcp_update_skb_after_send() (block D4). The rate
+ * gain is the ratio of the planned rate (the mean over the pacing stages, which
+ * are equally long) to the realized rate, smoothed over rounds,
+ * so that a host that paces slower or faster than asked (timer slack, TSQ,
+ * qdisc) still finishes the next red train in the idle part of the RTT. The
+ * start lateness is taken off the next guard.
+ */
+static void suss_pacing_feedback(struct sock *sk)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    u64 real = 0, late = 0, span, gain, asked;
+
+    if (!ss->red_pkts)
+	return;
+    asked = div_u64(ss->rate_sum, max_t(u32, ss->stage, 1));
+
+    if (ss->red_first_ns > tp->suss_pacing_start_ns)
+	late = div_u64(ss->red_first_ns - tp->suss_pacing_start_ns, NSEC_PER_USEC);
+    ss->pace_late_us = min_t(u64, late, U32_MAX);
+
+    span = ss->red_last_ns - ss->red_first_ns;
+    if (ss->red_pkts > ss->red_last_segs && span) {
+	real = div64_u64((u64)(ss->red_pkts - ss->red_last_segs) * tp->mss_cache * NSEC_PER_SEC, span);
+	if (real) {
+	    gain = div64_u64(asked << SUSS_SCALE, real);
+	    gain = (gain + ss->pace_gain) >> 1;
+	    ss->pace_gain = clamp_t(u64, gain, 1 << (SUSS_SCALE - 1), 1 << (SUSS_SCALE + 1));
+	}
+    }
+
+    printk(KERN_INFO "SUSSmsg id=%u Red train planned rate=%llu start=%llu, realized rate=%llu start=%llu pkts=%u. t=%u Sport=%u gain=%u late=%u",
+     tp->suss_msg_id, asked, tp->suss_pacing_start_ns, real, ss->red_first_ns, ss->red_pkts,
+     suss_clock_us(sk), inet_sk(sk)->inet_sport, ss->pace_gain, ss->pace_late_us);
+    ss->red_pkts = 0;
+}
+
+/* On high BDP paths, the idle part of the round is long enough to pace the red
+ * train in several stages (suss_stages). Each stage starts with the delivery
+ * rate of the current round so far, which is measured from the ACK train while
+ * the red train is paced. The rate can change at most by a factor of 2 per
+ * stage, and suss_pace_gain is applied once to it, not on top of the gain of
+ * the last stage. If the path delivers faster than the rest of the plan needs, the red
+ * train is extended within suss_red_max (at most the next growth factor, the
+ * rest of the flow and the receiver window); if it delivers slower, the stage
+ * is paced slower and the red packets that are not sent in this round are
+ * dropped from the plan, which bounds the queue that the jump can build up.
+ */
+static void suss_pacing_stage(struct sock *sk, u32 ack, u32 now)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    u32 stages = clamp(suss_stages, 1, SUSS_MAX_STAGES);
+    u32 elapsed = now - ss->round_start_us;
+    u64 start, end, remain_ns, deliv, need, rate;
+    u32 left, extra = 0;
+
+    if (ss->stage >= stages || sk->sk_pacing_status != SK_PACING_NEEDED || !elapsed)
+	return;
+
+    start = tp->suss_pacing_start_ns + (u64)ss->stage * ss->stage_ns;
+    end = tp->suss_pacing_start_ns + (u64)stages * ss->stage_ns;
+    if (tp->tcp_clock_cache < start || tp->tcp_clock_cache >= end)
+	return;
+    ss->stage++;
+
+    remain_ns = end - tp->tcp_clock_cache;
+    left = ss->red_plan - min(ss->red_pkts, ss->red_plan);
+    need = div64_u64((u64)left * tp->mss_cache * NSEC_PER_SEC, remain_ns);
+    deliv = div_u64((u64)(ack - ss->round_una) * USEC_PER_SEC, elapsed);
+    rate = clamp_t(u64, deliv, ss->base_rate >> 1, ss->base_rate << 1);
+
+    if (rate > need) {
+	extra = div64_u64((rate - need) * remain_ns, (u64)tp->mss_cache * NSEC_PER_SEC);
+	extra = min(extra, ss->red_max - min(ss->red_max, ss->red_plan));
+	ss->red_plan += extra;
+	tp->suss_limit += extra;
+    }
+
+    ss->base_rate = rate;
+    tp->suss_rate = (rate * ss->pace_gain) >> SUSS_SCALE;
+    if (ss->resv)
+	tp->suss_rate = min(tp->suss_rate, ss->resv);
+    ss->rate_sum += tp->suss_rate;
+    sk->sk_pacing_rate = tp->suss_rate;
+    printk(KERN_INFO "SUSSmsg id=%u Pacing stage %u of %u: rate %llu Bps (delivery %llu Bps, needed %llu Bps), %u packets are added. t=%u Sport=%u limit=%u c=%u i=%u",
+     tp->suss_msg_id, ss->stage, stages, tp->suss_rate, deliv, need, extra, now, inet_sk(sk)->inet_sport, tp->suss_limit, tp->snd_cwnd, tcp_packets_in_flight(tp));
+}
+
+static void suss_measurements(struct sock *sk, u32 ack, u32 acked)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    u32 now = suss_clock_us(sk);
+    u32 delay_min = suss_delay_min(sk);
+
+    /* Is it the first red ACK */
+    if (ss->is_blue == 2)
+	ss->is_blue = 0;
+
+    /* If it is the head of an ACK train then
+    1) increase round counter    2) switch to ACK clocking mode  */
+    if (ack > ss->head_seq) {
+	ss->is_blue = 1;
+	ss->blue_cnt = 0;
+	ss->round_no ++;
+	ss->round_start_us = now;
+	ss->last_ack = now;
+	ss->rtt_round = ~0U;
+	ss->head_seq = tp->snd_nxt;
+	ss->round_una = ack;
+	printk(KERN_INFO "SUSSmsg id=%u New round %u is started. t=%u Sport=%u c=%u i=%u",
+	 tp->suss_msg_id, ss->round_no, now, inet_sk(sk)->inet_sport, tp->snd_cwnd, tcp_packets_in_flight(tp));
+
+	if (tp->suss_state == 2)
+	    suss_pacing_feedback(sk);
+	suss_budget_release(sk);
+
+	cmpxchg(&sk->sk_pacing_status, SK_PACING_NEEDED, SK_PACING_NONE);//swtich to ACK clocking mode
+	tp->suss_state = 1;
+	ss->grad_n = 0;
+	ss->grad_sx = ss->grad_sy = ss->grad_sxx = ss->grad_sxy = 0;
+    }
+
+    /* If this is the tail of the blue part of an ACK train: measure delta_t_bat and quadruple cwnd if all conditions are satisfied. */
+    if (ack > ss->tail_seq) {
+	u64 rate, guard;
+	u32 temp, elapsed, blue_pkt, blue_ack, red_pkt, red_ack, delta_t_bat, pacing_duration;
+	u32 plan_pkt, trim_pkt, pace_us;
+
+	elapsed = (now - ss->round_start_us);
+	ss->is_blue = 2;
+	blue_pkt = TCP_INIT_CWND << (ss->round_no - 1);
+	blue_ack = blue_pkt >> 1;
+	ss->tail_seq = ss->head_seq + (blue_pkt * tp->mss_cache) - 1;
+
+	temp = max_t(u32, ss->blue_cnt, 1) << 1;
+	delta_t_bat= div64_long((u64) (blue_pkt * elapsed), temp);
+	printk(KERN_INFO "SUSSmsg id=%u Blue ACK train in round %u is received in %u us. t=%u Sport=%u dtB=%u c=%u i=%u",
+	 tp->suss_msg_id, ss->round_no, elapsed, now, inet_sk(sk)->inet_sport, delta_t_bat, tp->snd_cwnd, tcp_packets_in_flight(tp));
+
+	if (ss->gf == 1) {
+	    ss->gf = suss_speedup(sk, delta_t_bat);
+	}
+	/* Kept while the growth factor is off, so that suss_speedup compares with
+	the last round if it is turned on again (see hystart_plus_update). */
+	ss->perv_delta_t_bat = delta_t_bat;
+
+	if (ss->gf == 1) {
+	    u32 left = suss_pkts_left(sk);
+	    u32 headroom = tp->snd_cwnd + acked;
+	    u32 rwnd;
+
+	    /* A cap does not end the jumps below it; a jump only does not take
+	    cwnd beyond the cap, as if the flow ended there. */
+	    if (ss->flag)
+		left = min_t(u32, left, ss->cap - min_t(u32, ss->cap, tcp_packets_in_flight(tp)));
+
+	    red_pkt = (blue_pkt << (ss->round_no - 1)) - blue_pkt;
+	    red_ack = (blue_ack << (ss->round_no - 2)) - blue_ack;
+	    plan_pkt = red_pkt;
+
+	    /* Do not plan a jump beyond the end of the flow: if the rest of the flow
+	    fits in what ACK clocking sends in this round anyway (each red ACK sends two
+	    packets), no jump is needed; otherwise, the red train carries only the rest. */
+	    headroom -= min(headroom, tcp_packets_in_flight(tp));
+	    if (left <= headroom + (red_ack << 1))
+		red_pkt = 0;
+	    else
+		red_pkt = min(red_pkt, left - headroom);
+
+	    /* The same holds for what the receiver can absorb (see suss_rwnd_pkts). */
+	    rwnd = suss_rwnd_pkts(sk, red_ack);
+	    if (rwnd <= headroom + (red_ack << 1))
+		red_pkt = 0;
+	    else
+		red_pkt = min(red_pkt, rwnd - headroom);
+
+	    /* Parallel flows to the same destination share the idle time. */
+	    trim_pkt = red_pkt;
+	    red_pkt = suss_coord_split(sk, red_pkt, blue_pkt, delta_t_bat, delay_min);
+
+	    /* The rate is planned for the whole red train (as scaled by the split). A
+	    train that is trimmed above is paced at that rate and ends earlier: pacing
+	    it slower over the whole idle time would only delay the end of the flow.
+	    For the same reason, cwnd may grow to carry it without the red ACKs, which
+	    clock out red_ack packets of an untrimmed train. */
+	    plan_pkt = trim_pkt ? div_u64((u64)plan_pkt * red_pkt, trim_pkt) : 0;
+
+	    /* Later pacing stages may extend the red train up to the next growth factor. */
+	    ss->red_plan = red_pkt;
+	    ss->red_max = red_pkt ? min3(red_pkt << 1, left - headroom, rwnd - headroom) : 0;
+
+	    tp->suss_limit = (tp->snd_cwnd + acked) + red_pkt - (red_ack - min(red_ack, plan_pkt - red_pkt));
+	    pacing_duration = delay_min - (delay_min >> (ss->round_no - 1));
+	    pace_us = red_pkt ? div_u64((u64)pacing_duration * red_pkt, plan_pkt) : 0;
+	    rate = div64_long((u64) (plan_pkt * tp->mss_cache) * BW_UNIT, max(pacing_duration, 1U));
+	    rate *= USEC_PER_SEC;
+	    rate = rate >> BW_SCALE;
+	    /* Correct the rate and the guard by what the last red train achieved. */
+	    ss->base_rate = rate;
+	    rate = (rate * ss->pace_gain) >> SUSS_SCALE;
+	    tp->suss_rate = rate;
+
+	    temp = delay_min - pacing_duration;
+	    if (red_pkt && temp > delta_t_bat) {
+		red_pkt = suss_budget_admit(sk, red_pkt);
+		rate = tp->suss_rate;
+	    }
+	    if (red_pkt && temp > delta_t_bat) {
+		tp->suss_state = 2;
+		ss->num_of_jump += 1;
+		guard = (temp - delta_t_bat) >> 1;
+		guard = (guard - min_t(u64, guard, ss->pace_late_us)) * NSEC_PER_USEC;
+		tp->suss_pacing_start_ns = tp->tcp_clock_cache + guard;
+		ss->red_pkts = 0;
+		ss->stage = 1;
+		ss->rate_sum = tp->suss_rate;
+		ss->stage_ns = div_u64((u64)pace_us * NSEC_PER_USEC,
+					    clamp(suss_stages, 1, SUSS_MAX_STAGES));
+		printk(KERN_INFO "SUSSmsg id=%u Total amount of %u packets is paced in %u microSec with rate %llu Bps starting from time %llu ns. t=%u Sport=%u limit=%u delta_t_bat=%u guard=%llu left=%u rwnd=%u gain=%u",
+		 tp->suss_msg_id, red_pkt, pace_us, rate, tp->suss_pacing_start_ns, now, inet_sk(sk)->inet_sport, tp->suss_limit, delta_t_bat, guard, left, rwnd, ss->pace_gain);
+	    } else {
+		tp->suss_state = 1;
+	    }
+	}
+    }
+
+    if (ss->is_blue != 0) {
+	ss->blue_cnt += acked;
+    }
+
+    if (ss->is_blue == 0 && tp->suss_state == 2) {
+	tp->snd_cwnd -= acked;
+	suss_pacing_stage(sk, ack, now);
+    }
+}
+
+/* After an RTO, SUSS does not slow start from one packet. Once an ACK shows
+ * that the path delivers again, cwnd is set back to ssthresh and the window is
+ * paced out over one min RTT with the rate planned in tcp_suss_enter_loss().
+ * The next RTT is ACK clocked again.
+ */
+static void suss_recovery(struct sock *sk, u32 ack)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+
+    if (tp->suss_state == 5) {
+	tp->suss_state = 6;
+	ss->head_seq = tp->snd_nxt;
+	tp->snd_cwnd = max(tp->snd_cwnd, tp->suss_limit);
+	tp->tcp_wstamp_ns = max(tp->tcp_wstamp_ns, tp->tcp_clock_cache);
+	cmpxchg(&sk->sk_pacing_status, SK_PACING_NONE, SK_PACING_NEEDED); //swtich to pacing mode
+	sk->sk_pacing_rate = tp->suss_rate;
+	printk(KERN_INFO "SUSSmsg id=%u Recovery after RTO: %u packets are paced with rate %llu Bps. t=%u Sport=%u c=%u i=%u",
+	 tp->suss_msg_id, tp->suss_limit, tp->suss_rate, suss_clock_us(sk), inet_sk(sk)->inet_sport, tp->snd_cwnd, tcp_packets_in_flight(tp));
+    } else if (after(ack, ss->head_seq)) {
+	tp->suss_state = 10;
+	cmpxchg(&sk->sk_pacing_status, SK_PACING_NEEDED, SK_PACING_NONE); //swtich to ACK clocking mode
+	printk(KERN_INFO "SUSSmsg id=%u Recovery after RTO is done. t=%u Sport=%u c=%u i=%u",
+	 tp->suss_msg_id, suss_clock_us(sk), inet_sk(sk)->inet_sport, tp->snd_cwnd, tcp_packets_in_flight(tp));
+    }
+}
+
+/* Called on RTO (state 5, see tcp_enter_loss), once the congestion control
+ * has set ssthresh. The pacing rate sends ssthresh packets (the share of the
+ * pre-loss window that the congestion control keeps) in one min RTT measured
+ * before the loss.
+ */
+void tcp_suss_enter_loss(struct sock *sk)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    u32 delay_min = suss_delay_min(sk);
+
+    if (tp->suss_state != 5)
+	return;
+
+    if (!suss_rto || !delay_min || tp->snd_ssthresh < TCP_INIT_CWND ||
+	tp->snd_ssthresh >= TCP_INFINITE_SSTHRESH || tp->snd_ssthresh <= tp->snd_cwnd) {
+	tp->suss_state = 10;
+	return;
+    }
+
+    tp->suss_limit = tp->snd_ssthresh;
+    tp->suss_rate = div64_u64((u64)tp->suss_limit * tp->mss_cache * USEC_PER_SEC, delay_min);
+}
+
+/* Account for TSO/GRO delays, as hystart_ack_delay() in tcp_cubic.c */
+static u32 suss_ack_delay(const struct sock *sk)
+{
+    unsigned long rate = READ_ONCE(sk->sk_pacing_rate);
+
+    if (!rate)
+	return 0;
+    return min_t(u64, USEC_PER_MSEC,
+		 div64_ul((u64)sk->sk_gso_max_size * 4 * USEC_PER_SEC, rate));
+}
+
+/* Adds an RTT sample of the blue train to the least-squares fit of the queueing
+ * delay (rtt - delay_min) over the time since the start of the round. Returns the
+ * gradient of the fit scaled by SUSS_SCALE (1 << SUSS_SCALE means the queueing
+ * delay grows 1 us per us), or -1 while there are too few samples.
+ * Ranges: x < 2^16, y <= 2^20, n <= 2^12, so no sum or product overflows 64 bits.
+ */
+static s64 suss_delay_gradient(struct sock *sk, u32 delay)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    u32 x = min_t(u32, (suss_clock_us(sk) - ss->round_start_us) >> SUSS_GRAD_XSHIFT, 0xffff);
+    u32 y = min_t(u32, delay - min(delay, suss_delay_min(sk)), 1 << 20);
+    u64 n = ss->grad_n;
+    u64 den;
+    s64 num;
+
+    if (n < (1 << 12)) {
+	ss->grad_n = ++n;
+	ss->grad_sx += x;
+	ss->grad_sy += y;
+	ss->grad_sxx += (u64)x * x;
+	ss->grad_sxy += (u64)x * y;
+    }
+    if (n < SUSS_GRAD_MIN_SAMPLES)
+	return -1;
+
+    den = n * ss->grad_sxx - ss->grad_sx * ss->grad_sx;
+    den >>= SUSS_SCALE - SUSS_GRAD_XSHIFT;
+    if (!den)
+	return -1;
+    num = (s64)(n * ss->grad_sxy) - (s64)(ss->grad_sx * ss->grad_sy);
+
+    return div64_s64(num, den);
+}
+
+/* Returns true if it ends the exponential growth of cwnd */
+static bool suss_cap(struct sock *sk, u32 delay, u32 ack_delta_us)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    u32 threshold;
+    u32 now = suss_clock_us(sk);
+    u32 delay_min = suss_delay_min(sk);
+
+    u32 temp;
+    if (ss->flag == 1 && tp->snd_cwnd > ss->cap) {
+	printk(KERN_INFO "SUSSmsg id=%u Stop exponential growth (type=3): t=%u Sport=%u cap=%u ssthresh=%u c=%u i=%u",
+	 tp->suss_msg_id, now, inet_sk(sk)->inet_sport, ss->cap, tp->snd_ssthresh, tp->snd_cwnd, tcp_packets_in_flight(tp));
+	tp->suss_state = 3;
+	if (ss->num_of_jump > 1) {
+	    tp->snd_cwnd = tcp_packets_in_flight(tp);
+	}
+
+	tp->snd_ssthresh = tp->snd_cwnd;
+	return true;
+    }
+
+    /* The queue builds up once the blue train is sent faster than the bottleneck
+    delivers it. The bottleneck rate is then the rate of the blue ACKs, and the cap
+    is the BDP it gives with delay_min. A blue train is sent at twice the rate of
+    its ACKs, so one that fills the bottleneck for a moment builds a short queue
+    even on a path with a much larger BDP: the gradient has to pass in the blue
+    trains of two rounds in a row. */
+    if (suss_gradient && ss->flag == 0 && tp->suss_state < 3 && ss->is_blue != 0 &&
+	ss->grad_round != ss->round_no) {
+	s64 grad = suss_delay_gradient(sk, delay);
+
+	if (grad >= SUSS_GRAD_THRESH && ss->grad_round + 1 != ss->round_no) {
+	    ss->grad_round = ss->round_no;
+	} else if (grad >= SUSS_GRAD_THRESH) {
+	    u32 elapsed = max(now - ss->round_start_us, 1U);
+	    u64 bdp = div_u64((u64)ss->blue_cnt * delay_min, elapsed);
+
+	    ss->grad_round = ss->round_no;
+	    ss->flag = 1;
+	    ss->cap = min_t(u64, max_t(u64, bdp, tp->snd_cwnd), (1 << 14) - 1);
+	    printk(KERN_INFO "SUSSmsg id=%u Cap is set: t=%u Sport=%u cap=%u ssthresh=%u c=%u i=%u grad=%lld n=%u",
+	     tp->suss_msg_id, now, inet_sk(sk)->inet_sport, ss->cap, tp->snd_ssthresh, tp->snd_cwnd, tcp_packets_in_flight(tp), grad, ss->grad_n);
+	}
+    }
+
+    if (!suss_gradient && ss->flag == 0 && tp->suss_state < 3 && ss->is_blue != 0) {
+	if ((s32)(now - ss->last_ack) <= (s32)ack_delta_us) {
+	    ss->last_ack = now;
+	    threshold = delay_min + suss_ack_delay(sk);
+	    threshold >>= 1;
+	    temp = (now - ss->round_start_us) << ss->num_of_jump;
+	    if (temp > threshold) {
+		ss->flag = 1;
+		ss->cap = tp->snd_cwnd + (ss->blue_cnt * ((1 << ss->num_of_jump) - 1));
+		printk(KERN_INFO "SUSSmsg id=%u Cap is set: t=%u Sport=%u cap=%u ssthresh=%u c=%u i=%u",
+		 tp->suss_msg_id, now, inet_sk(sk)->inet_sport, ss->cap, tp->snd_ssthresh, tp->snd_cwnd, tcp_packets_in_flight(tp));
+	    }
+	}
+    }
+    return false;
+}
+
+/* For a congestion control that detects the ACK train itself (HyStart in
+ * CUBIC): it sets suss_nocap and calls this where it checks the train, with its
+ * own threshold of the ACK spacing and below its own minimum window. Returns
+ * true if SUSS ended the exponential growth, so that the congestion control
+ * stops its own detection too. */
+bool tcp_suss_cap(struct sock *sk, u32 delay, u32 ack_delta_us)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+
+    if (tp->suss_state == 0 || tp->suss_state == 10)
+	return false;
+    return suss_cap(sk, max(delay, 1U), ack_delta_us);
+}
+EXPORT_SYMBOL_GPL(tcp_suss_cap);
+
+/* Frees the state of SUSS of sk, if it is its own (see tcp_suss_init). SUSS
+ * does nothing for the flow until tcp_suss_init() runs again. */
+static void suss_free(struct sock *sk)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+
+    if (tp->suss && tp->suss->sk == sk)
+	kfree(tp->suss);
+    tp->suss = NULL;
+    tp->suss_log = 0;
+    tp->suss_state = 10;
+}
+
+/* Called from the init of the congestion control, before it sets its own
+ * slow start state. A congestion control that runs the cap itself (see
+ * tcp_suss_cap) or ends slow start by itself sets suss_nocap afterwards.
+ */
+void tcp_suss_init(struct sock *sk)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+
+    tp->suss_nocap = 0;
+    tp->suss_state = 10;
+    /* The flows of the experiment port are logged (SUSSmsg@) with and without
+     * SUSS, so that runs with suss=0 can be compared with the others. Only
+     * they get the state of SUSS. */
+    tp->suss_log = (sk->sk_pacing_status == SK_PACING_NONE) &&
+		   (inet_sk(sk)->inet_sport==20480 || inet_sk(sk)->inet_dport==20480);
+    if (!tp->suss_log) {
+	suss_free(sk);
+	return;
+    }
+
+    /* A socket that is connected again still has its state, with what it
+     * holds in the netns; one that is cloned from a listener has the pointer
+     * of the listener. */
+    if (ss && ss->sk == sk) {
+	suss_coord_leave(sk);
+	suss_budget_release(sk);
+    } else {
+	ss = kmalloc(sizeof(*ss), GFP_ATOMIC);
+	if (!ss) {
+	    tp->suss = NULL;
+	    tp->suss_log = 0;
+	    return;
+	}
+	tp->suss = ss;
+    }
+    memset(ss, 0, sizeof(*ss));
+    ss->sk = sk;
+
+    ss->num_of_jump = 0;
+    ss->dst_saved = 0;
+    ss->gf   = 1;
+    ss->flag = 0;
+    ss->cap  = 0;
+    ss->is_blue = 0;
+    ss->blue_cnt = 0;
+    ss->r_minupdate = 0;
+    ss->perv_delta_t_bat = 0;
+    ss->round_no = 1;
+    /* The first train starts at snd_una, not snd_nxt: at a TCP Fast Open
+     * client, data sent with the SYN may still be in flight here and belongs to
+     * the initial window. At a server, tcp_init_transfer() runs before any data
+     * is sent, so snd_una == snd_nxt there. */
+    ss->head_seq = tp->snd_una;
+    ss->tail_seq = tp->snd_una + (TCP_INIT_CWND * tp->mss_cache) - 1;
+    ss->round_start_us = ss->last_ack = suss_clock_us(sk);
+    ss->rtt_round = ~0U;
+    /* Seed the RTT reference with the handshake RTT, unless the SYN or SYN-ACK
+     * was retransmitted (Karn). It carries no serialization delay, so it sits
+     * below the ACK samples of the path; kept as the min, it would hold
+     * delay_min at the bare propagation delay (e.g., exactly 10000 us, which
+     * fails the round 2 check of suss_speedup). The first ACK sample replaces
+     * it, whatever its value. */
+    minmax_reset(&ss->rtt_min, suss_clock_us(sk), ~0U);
+    ss->seed = SUSS_SEED_NONE;
+    if (tp->srtt_us && !tp->total_retrans) {
+	minmax_reset(&ss->rtt_min, suss_clock_us(sk), max(tp->srtt_us >> 3, 1U));
+	ss->seed = SUSS_SEED_SYN;
+    }
+    ss->red_pkts = 0;
+    ss->pace_gain = 1 << SUSS_SCALE;
+    ss->pace_late_us = 0;
+    ss->max_jumps = suss_dst_jumps(sk);
+    if (suss) {
+	tp->suss_state = 1;
+	suss_coord_join(sk);
+    }
+}
+EXPORT_SYMBOL_GPL(tcp_suss_init);
+
+void tcp_suss_release(struct sock *sk)
+{
+    if (tcp_sk(sk)->suss_log) {
+	suss_coord_leave(sk);
+	suss_budget_release(sk);
+    }
+    suss_free(sk);
+}
+
+/* Called for every ACK that gives an RTT sample, before the pkts_acked of the
+ * congestion control. */
+void tcp_suss_acked(struct sock *sk, s32 rtt_us)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    u32 delay, rtt_min;
+
+    if (rtt_us < 0 || tp->suss_state == 0 || tp->suss_state == 10)
+	return;
+
+    delay = max_t(u32, rtt_us, 1);
+    rtt_min = minmax_get(&ss->rtt_min);
+    if (ss->seed == SUSS_SEED_SYN) {
+	/* The filter starts from the first sample, as without a seed */
+	rtt_min = minmax_reset(&ss->rtt_min, suss_clock_us(sk), ~0U);
+    } else if (ss->seed == SUSS_SEED_DST) {
+	/* A cached min RTT of the destination (suss_coord_join) above the
+	 * first sample is replaced by the filter anyway. One well below it
+	 * (e.g., the route changed) is dropped. */
+	if (delay > rtt_min + (rtt_min >> 2) + SUSS_SEED_SLACK)
+	    rtt_min = minmax_reset(&ss->rtt_min, suss_clock_us(sk), delay);
+    }
+    ss->seed = SUSS_SEED_NONE;
+    if (minmax_running_min(&ss->rtt_min, suss_rtt_win * USEC_PER_MSEC,
+			   suss_clock_us(sk), delay) != rtt_min)
+	ss->r_minupdate = ss->round_no;
+    if (ss->rtt_round > delay)
+	ss->rtt_round = delay;
+
+    if (!tp->suss_nocap && tcp_in_slow_start(tp) && tcp_snd_cwnd(tp) >= SUSS_CAP_WINDOW)
+	suss_cap(sk, delay, SUSS_ACK_DELTA_US);
+}
+
+/* An ECE on an ACK of the blue train means the queue was already building up
+ * with the window of the previous round, before the red train of the planned
+ * jump. The jump is cancelled: pacing stops and cwnd goes back to what is in
+ * flight without the red packets sent so far, so that the cwnd reduction that
+ * follows (tcp_enter_cwr) starts from the window that got marked rather than
+ * from the jump. An ECE on a red ACK cuts cwnd to what is in flight. In both
+ * cases, growth stops at suss_cap and no later jump is taken.
+ */
+void tcp_suss_in_ack_event(struct sock *sk, u32 flags)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    u32 inflight, cwnd;
+    bool blue;
+
+    if (tp->suss_state == 0 || tp->suss_state > 2)
+	return;
+    blue = (ss->is_blue == 1) || after(tp->snd_una, ss->head_seq);
+    if (after(tp->snd_una, ss->head_seq))
+	ss->blue_ce = 0;
+    if (!(flags & CA_ACK_ECE))
+	return;
+    if (blue)
+	ss->blue_ce++;
+
+    inflight = tcp_packets_in_flight(tp);
+    cwnd = inflight;
+    if (blue && tp->suss_state == 2 && inflight > ss->red_pkts)
+	cwnd = inflight - ss->red_pkts;
+    cwnd = max(cwnd, 2U);
+
+    cmpxchg(&sk->sk_pacing_status, SK_PACING_NEEDED, SK_PACING_NONE); //swtich to ACK clocking mode
+    tp->snd_cwnd = min(tp->snd_cwnd, cwnd);
+    tp->suss_limit = tp->snd_cwnd;
+    ss->gf = 0;
+    ss->cap = min(tp->snd_cwnd, (1U << 14) - 1);
+    ss->flag = 1;
+    printk(KERN_INFO "SUSSmsg id=%u ECE in the %s train of round %u. t=%u Sport=%u state=%u ce=%u red=%u c=%u i=%u",
+     tp->suss_msg_id, blue ? "blue" : "red", ss->round_no, suss_clock_us(sk), inet_sk(sk)->inet_sport,
+     tp->suss_state, ss->blue_ce, ss->red_pkts, tp->snd_cwnd, inflight);
+    tp->suss_state = 3;
+}
+
+/* Called when cwnd is reduced for a loss or ECN (tcp_init_cwnd_reduction,
+ * before the congestion control sets ssthresh) and on RTO (tcp_enter_loss,
+ * after it). A flow that leaves slow start this way after jumping caches one
+ * jump less for its destination. */
+void tcp_suss_cwnd_reduction(struct sock *sk)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+
+    if (tp->suss_log && ss->num_of_jump && !ss->dst_saved)
+	suss_dst_save(sk, ss->num_of_jump - 1);
+}
+
+/* Called at the start of cong_avoid of the congestion control, which then
+ * grows cwnd in slow start as usual. A congestion control that reaches it
+ * without calling tcp_suss_init() (e.g., Vegas through tcp_reno_cong_avoid)
+ * has no state of SUSS: suss_log is cleared for every congestion control in
+ * tcp_init_congestion_control() and by tcp_suss_release(). */
+void tcp_suss_cong_avoid(struct sock *sk, u32 ack, u32 acked)
+{
+    struct tcp_sock *tp = tcp_sk(sk);
+    struct tcp_suss *ss = tp->suss;
+    u32 una = tp->snd_una - tp->snd_isn;
+
+    if (!tp->suss_log)
+	return;
+
+    if ((tp->suss_state == 5) || (tp->suss_state == 6))
+	suss_recovery(sk, ack);
+
+    if ((tp->suss_state > 2) && (tp->suss_state < 10) && (tp->suss_state != 6) && (sk->sk_pacing_status == SK_PACING_NEEDED))
+	cmpxchg(&sk->sk_pacing_status, SK_PACING_NEEDED, SK_PACING_NONE); //swtich to clocking mode
+
+    if (tp->suss_state < 3 && (ss->flag == 0 || tp->snd_cwnd < ss->cap))
+	suss_measurements(sk, ack, acked);
+
+    if (ss->coord && tp->suss_state > 2)
+	suss_coord_leave(sk);
+
+    if (ss->resv && tp->suss_state != 2)
+	suss_budget_release(sk);
+
+    if (ss->num_of_jump && !ss->dst_saved && !tcp_in_slow_start(tp) && (tp->suss_state < 5 || tp->suss_state == 10))
+	suss_dst_save(sk, ss->max_jumps + (ss->num_of_jump >= ss->max_jumps));
+
+    printk(KERN_INFO "SUSSmsg@ id=%u t=%llu Sport=%u c=%u i=%u a=%u "
+    "RTT=%u moRTT=%u minRTT=%u d=%u l=%u "
+    "tRnd=%u s=%u Bcnt=%u Rnd=%u ",
+    tp->suss_msg_id, tp->tcp_mstamp, inet_sk(sk)->inet_sport, tp->snd_cwnd, tcp_packets_in_flight(tp), acked,
+    (tp->srtt_us >> 3), ss->rtt_round, suss_delay_min(sk), una, tp->lost,
+    ss->round_start_us, tp->suss_state, ss->blue_cnt, ss->round_no);
+}
+EXPORT_SYMBOL_GPL(tcp_suss_cong_avoid);
+
+static int __init tcp_suss_register(void)
+{
+	return register_pernet_subsys(&suss_net_ops);
+}
+fs_initcall(tcp_suss_register);
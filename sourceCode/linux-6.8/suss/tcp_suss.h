@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * SUSS: Speeding Up Slow Start, independent of the congestion control.
+ *
+ * The few fields of SUSS that the TCP core reads on every packet (suss_state,
+ * suss_limit, suss_rate, ...) are in struct tcp_sock. The rest is in struct
+ * tcp_suss, which tcp_suss_init() allocates only for the flows that SUSS runs
+ * on (tp->suss, see suss_log), so that any congestion control can use it next
+ * to its own private data. The TCP core feeds SUSS with RTT samples, ECE and
+ * loss events for every congestion control; a congestion control that wants
+ * the faster slow start calls tcp_suss_init() from its init and
+ * tcp_suss_cong_avoid() at the start of its cong_avoid. Reno and the
+ * congestion controls that use tcp_reno_cong_avoid (e.g., DCTCP) get both
+ * from tcp_cong.c.
+ */
+#ifndef _TCP_SUSS_H
+#define _TCP_SUSS_H
+
+#include <linux/types.h>
+#include <linux/tcp.h>
+#include <linux/win_minmax.h>
+
+struct sock;
+
+struct tcp_suss {
+	const struct sock *sk;		/* owner of the state				*/
+	struct minmax	rtt_min;	/* windowed min RTT (us), used as delay_min	*/
+	u64	base_rate;		/* rate of the current pacing stage before pace_gain	*/
+	u64	rate_sum;		/* sum of suss_rate over the started pacing stages	*/
+	u64	resv;			/* rate (Bps) reserved from the netns budget	*/
+	u64	red_first_ns;		/* departure of the first packet of the red train	*/
+	u64	red_last_ns;		/* departure of the last packet of the red train	*/
+	u64	grad_sx;		/* sums of the least-squares fit of the queueing	*/
+	u64	grad_sy;		/* delay (y) over time (x) in the blue train	*/
+	u64	grad_sxx;
+	u64	grad_sxy;
+	u32	grad_n;			/* number of samples in the fit			*/
+	u32	head_seq;		/* head of the blue part of the data train	*/
+	u32	tail_seq;		/* tail of the blue part of the data train	*/
+	u32	round_start_us;		/* start time of the current round		*/
+	u32	round_una;		/* snd_una at the head of the current round	*/
+	u32	rtt_round;		/* min RTT (us) of the current round		*/
+	u32	last_ack;		/* last time the ACK spacing was close (cap)	*/
+	u32	red_pkts;		/* packets of the red train sent so far		*/
+	u32	red_plan;		/* red packets planned in the current round	*/
+	u32	red_max;		/* max of red packets later stages can plan	*/
+	u32	stage_ns;		/* length of each pacing stage			*/
+	u32	pace_late_us;		/* delay of the first red packet behind suss_pacing_start_ns	*/
+	u16	pace_gain;		/* correction of suss_rate (1 << 10 means none)	*/
+	u16	red_last_segs;		/* packets in the last skb of the red train	*/
+	u16	blue_ce;		/* ECE ACKs in the blue train of the round	*/
+	u8	stage;			/* pacing stages of the red train started	*/
+	u8	max_jumps;		/* max of jumps for this flow			*/
+	u8	grad_round;		/* last round whose blue train passed the delay gradient	*/
+	u8	seed;			/* what rtt_min holds before the first ACK sample (SUSS_SEED_*)	*/
+	u64	round_no	:5,	/* the current round number			*/
+		gf		:1,	/* cwnd is quadrupled when gf is one		*/
+		is_blue		:2,	/* it is 0 if the received ACK is red		*/
+		flag		:1,	/* flag=1 means stop EG when cwnd reaches cap	*/
+		cap		:14,	/* cwnd at which EG is stopped when flag=1	*/
+		r_minupdate	:5,	/* in which round minRTT was updated		*/
+		blue_cnt	:12,	/* number of received blue ACKs in the round	*/
+		perv_delta_t_bat:18,	/* how long the blue ACK train of the previous round took	*/
+		num_of_jump	:3,	/* number of pacing periods			*/
+		dst_saved	:1,	/* the outcome of slow start is cached		*/
+		coord		:1;	/* counted in the per destination table		*/
+};
+
+/* Number of jumps SUSS took in this slow start (0 without SUSS) */
+static inline u32 tcp_suss_jumps(const struct tcp_sock *tp)
+{
+	return tp->suss_log ? tp->suss->num_of_jump : 0;
+}
+
+/* Used by the congestion controls */
+void tcp_suss_init(struct sock *sk);
+void tcp_suss_cong_avoid(struct sock *sk, u32 ack, u32 acked);
+bool tcp_suss_cap(struct sock *sk, u32 delay, u32 ack_delta_us);
+
+/* Used by the TCP core */
+void tcp_suss_release(struct sock *sk);
+void tcp_suss_acked(struct sock *sk, s32 rtt_us);
+void tcp_suss_in_ack_event(struct sock *sk, u32 flags);
+void tcp_suss_cwnd_reduction(struct sock *sk);
+void tcp_suss_enter_loss(struct sock *sk);
+
+/* Used by the owner of the socket */
+void tcp_suss_set_flow_size(struct sock *sk, u32 bytes);
+
+#endif /* _TCP_SUSS_H */
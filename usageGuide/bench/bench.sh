@@ -0,0 +1,264 @@
+#!/bin/bash
+# Downloads files of several sizes through an emulated path on this machine,
+# with SUSS disabled and enabled, and reports the flow completion times (FCT)
+# and the improvement of SUSS for each cell of the grid. Run it as root on a
+# server where SUSS is installed; it needs ip, tc, curl and python3.
+#
+#   sudo bash bench.sh --rate 50,100 --rtt 20,50,100 --size 100k,1m,16m
+#
+# The path is four network namespaces joined by veth pairs:
+#
+#   suss-srv --- suss-dly --- suss-btl --- suss-cli
+#
+# suss-srv runs the web server (port 80) with the congestion control of
+# --cc. suss-dly delays each direction by half the RTT with netem and drops
+# the packets of the data with the probability of --loss. suss-btl is the
+# bottleneck: tbf with a drop-tail buffer of --buffer BDPs, or cake. Each
+# download comes from a fresh address of suss-cli, so the per destination
+# state of SUSS learned by one download does not carry over to the next, in
+# the same cell or in the next one.
+
+set -e
+
+rates=100
+rtts=50
+losses=0
+buffers=1
+qdiscs=tbf
+sizes=100k,1m,4m,16m
+reps=10
+cc=cubic
+out=bench.out
+keep=0
+
+usage() {
+    cat >&2 <<EOF
+Usage: $0 [options]
+Options with lists take comma separated values; the grid is all their combinations.
+  --rate LIST      bottleneck rate in Mbit/s ($rates)
+  --rtt LIST       base RTT in ms ($rtts)
+  --loss LIST      random loss of the data in percent ($losses)
+  --buffer LIST    buffer of tbf in BDPs ($buffers)
+  --qdisc LIST     tbf or cake ($qdiscs)
+  --size LIST      bytes per download, with k, m or g ($sizes)
+  --reps N         downloads per cell with and without SUSS ($reps)
+  --cc NAME        congestion control of the server ($cc)
+  --out DIR        where runs.tsv and summary.tsv go ($out)
+  --keep           leave the namespaces for inspection
+EOF
+    exit 1
+}
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+    --rate) rates=$2; shift ;;
+    --rtt) rtts=$2; shift ;;
+    --loss) losses=$2; shift ;;
+    --buffer) buffers=$2; shift ;;
+    --qdisc) qdiscs=$2; shift ;;
+    --size) sizes=$2; shift ;;
+    --reps) reps=$2; shift ;;
+    --cc) cc=$2; shift ;;
+    --out) out=$2; shift ;;
+    --keep) keep=1 ;;
+    *) usage ;;
+    esac
+    [ -n "$1" ] || usage
+    shift
+done
+
+if [ "$(id -u)" -ne 0 ]; then
+    echo "Run $0 as root." >&2
+    exit 1
+fi
+for tool in ip tc curl python3; do
+    if ! command -v $tool > /dev/null; then
+        echo "$tool is missing." >&2
+        exit 1
+    fi
+done
+
+# The module parameter suss: tcp_suss with Linux 6.8, tcp_cubic with 5.19.10
+param=/sys/module/tcp_suss/parameters/suss
+[ -f $param ] || param=/sys/module/tcp_cubic/parameters/suss
+if [ ! -f $param ]; then
+    echo "SUSS is not installed: there is no module parameter suss." >&2
+    exit 1
+fi
+suss_saved=$(cat $param)
+
+srv=suss-srv; dly=suss-dly; btl=suss-btl; cli=suss-cli
+www=$(mktemp -d)
+
+cleanup() {
+    echo "$suss_saved" > $param
+    [ -n "$server" ] && kill $server 2> /dev/null
+    rm -rf "$www"
+    if [ $keep -eq 0 ]; then
+        for ns in $srv $dly $btl $cli; do
+            ip netns del $ns 2> /dev/null || true
+        done
+    fi
+}
+trap cleanup EXIT
+
+bytes() {
+    echo "$1" | awk '{ n = $1 + 0; u = tolower(substr($1, length($1)));
+        if (u == "k") n *= 1024; else if (u == "m") n *= 1048576; else if (u == "g") n *= 1073741824;
+        printf "%d\n", n }'
+}
+
+# The namespaces, their links and routes
+for ns in $srv $dly $btl $cli; do
+    ip netns del $ns 2> /dev/null || true
+    ip netns add $ns
+    ip -n $ns link set lo up
+done
+ip link add name s0 netns $srv type veth peer name d0 netns $dly
+ip link add name d1 netns $dly type veth peer name b0 netns $btl
+ip link add name b1 netns $btl type veth peer name c0 netns $cli
+ip -n $srv addr add 10.55.1.1/24 dev s0
+ip -n $dly addr add 10.55.1.2/24 dev d0
+ip -n $dly addr add 10.55.2.1/24 dev d1
+ip -n $btl addr add 10.55.2.2/24 dev b0
+ip -n $btl addr add 10.56.0.1/16 dev b1
+ip -n $cli addr add 10.56.0.2/16 dev c0
+for dev in $srv:s0 $dly:d0 $dly:d1 $btl:b0 $btl:b1 $cli:c0; do
+    ns=${dev%:*}; dev=${dev#*:}
+    ip -n $ns link set $dev up
+    # Segments of one MSS, so that a loss is one packet and the bottleneck
+    # sees packets as on a real link
+    if command -v ethtool > /dev/null; then
+        ip netns exec $ns ethtool -K $dev tso off gso off gro off > /dev/null 2>&1 || true
+    fi
+done
+ip -n $srv route add default via 10.55.1.2
+ip -n $dly route add 10.56.0.0/16 via 10.55.2.2
+ip -n $btl route add default via 10.55.2.1
+ip -n $cli route add default via 10.56.0.1
+ip netns exec $dly sysctl -qw net.ipv4.ip_forward=1
+ip netns exec $btl sysctl -qw net.ipv4.ip_forward=1
+
+# The server keeps no metrics between connections, and both ends have
+# buffers for the largest BDP of the grid
+ip netns exec $srv sysctl -qw net.ipv4.tcp_congestion_control=$cc
+ip netns exec $srv sysctl -qw net.ipv4.tcp_no_metrics_save=1
+ip netns exec $srv sysctl -qw net.ipv4.tcp_wmem="4096 65536 134217728"
+ip netns exec $cli sysctl -qw net.ipv4.tcp_rmem="4096 131072 134217728"
+
+for size in ${sizes//,/ }; do
+    truncate -s $(bytes $size) "$www/$size"
+done
+ip netns exec $srv python3 -m http.server 80 --bind 10.55.1.1 --directory "$www" \
+    > /dev/null 2>&1 &
+server=$!
+for i in $(seq 50); do
+    ip netns exec $cli curl -s -m 1 -o /dev/null http://10.55.1.1/ && break
+    sleep 0.1
+done
+
+mkdir -p "$out"
+runs=$out/runs.tsv
+echo "# rate rtt loss buffer qdisc size suss rep fct_us" > $runs
+
+dl=0
+for rate in ${rates//,/ }; do
+for rtt in ${rtts//,/ }; do
+for loss in ${losses//,/ }; do
+for buffer in ${buffers//,/ }; do
+for qdisc in ${qdiscs//,/ }; do
+    # Half the RTT each way, and the loss on the way of the data
+    half=$(awk -v r=$rtt 'BEGIN { printf "%.3f", r / 2 }')
+    tc -n $dly qdisc replace dev d1 root netem delay ${half}ms loss ${loss}% limit 1000000
+    tc -n $dly qdisc replace dev d0 root netem delay ${half}ms limit 1000000
+
+    # tbf drops at --buffer BDPs (at least two packets) and sends bursts of
+    # at most 1 ms at its rate; cake keeps its own queue
+    bdp=$(awk -v r=$rate -v t=$rtt 'BEGIN { printf "%d", r * t * 125 }')
+    case $qdisc in
+    tbf)
+        limit=$(awk -v b=$buffer -v d=$bdp 'BEGIN { l = b * d; printf "%d", l < 3028 ? 3028 : l }')
+        burst=$(awk -v r=$rate 'BEGIN { b = r * 125; printf "%d", b < 3028 ? 3028 : b }')
+        tc -n $btl qdisc replace dev b1 root tbf rate ${rate}mbit burst $burst limit $limit ;;
+    cake)
+        tc -n $btl qdisc replace dev b1 root cake bandwidth ${rate}mbit besteffort ;;
+    *)
+        echo "Unknown qdisc $qdisc." >&2
+        exit 1 ;;
+    esac
+
+    # Time for the queues of the previous download to drain
+    gap=$(awk -v t=$rtt 'BEGIN { g = 4 * t / 1000; printf "%.3f", g < 0.2 ? 0.2 : g }')
+
+    for size in ${sizes//,/ }; do
+        echo "rate=$rate rtt=$rtt loss=$loss buffer=$buffer qdisc=$qdisc size=$size" >&2
+        for rep in $(seq $reps); do
+            # Alternate the order, so that a drift of the machine hits both
+            order="0 1"
+            [ $((rep % 2)) -eq 0 ] && order="1 0"
+            for suss in $order; do
+                echo $suss > $param
+                # A fresh client address: 10.56.1.2 to 10.56.255.251
+                dl=$((dl + 1))
+                if [ $dl -gt $((255 * 250)) ]; then
+                    echo "The grid has more than $((255 * 250)) downloads." >&2
+                    exit 1
+                fi
+                addr=10.56.$(((dl - 1) / 250 + 1)).$(((dl - 1) % 250 + 2))
+                ip -n $cli addr add $addr/16 dev c0
+                sleep $gap
+                res=$(ip netns exec $cli curl -s -m 600 -o /dev/null --interface $addr \
+                    -w '%{time_connect} %{time_total} %{size_download}' \
+                    http://10.55.1.1/$size) || res=
+                ip -n $cli addr del $addr/16 dev c0
+                # From the request to the last byte; "-" if the download failed
+                fct=$(echo "$res" | awk -v n=$(bytes $size) \
+                    'NF == 3 && $3 == n { printf "%.0f", ($2 - $1) * 1e6; exit } { print "-" }')
+                echo "$rate $rtt $loss $buffer $qdisc $size $suss $rep $fct" >> $runs
+            done
+        done
+    done
+done
+done
+done
+done
+done
+
+# Per cell and setting: the number of downloads and the 10th, 50th and 90th
+# percentiles and the mean of the FCT; the improvement of SUSS is that of
+# the median and of the mean, in percent of the FCT without SUSS
+summary=$out/summary.tsv
+awk '
+function stats(i,    j, k, x, n) {
+    n = cnt[i]
+    for (j = 2; j <= n; j++)
+        for (k = j; k > 1 && v[i, k - 1] > v[i, k]; k--) {
+            x = v[i, k]; v[i, k] = v[i, k - 1]; v[i, k - 1] = x
+        }
+    return sprintf("%d %d %d %d %.0f", n, v[i, int((n - 1) * 0.1 + 0.5) + 1],
+                   v[i, int((n - 1) * 0.5 + 0.5) + 1], v[i, int((n - 1) * 0.9 + 0.5) + 1], sum[i] / n)
+}
+/^#/ || $9 == "-" { next }
+{
+    key = $1 " " $2 " " $3 " " $4 " " $5 " " $6
+    if (!(key in seen)) { seen[key] = 1; keys[++nk] = key }
+    i = key SUBSEP $7
+    v[i, ++cnt[i]] = $9; sum[i] += $9
+}
+END {
+    print "# rate rtt loss buffer qdisc size n0 fct0_p10 fct0_p50 fct0_p90 fct0_mean n1 fct1_p10 fct1_p50 fct1_p90 fct1_mean impr_p50 impr_mean"
+    for (j = 1; j <= nk; j++) {
+        a = keys[j] SUBSEP 0; b = keys[j] SUBSEP 1
+        if (!cnt[a] || !cnt[b]) continue
+        split(stats(a), s0, " "); split(stats(b), s1, " ")
+        printf "%s %s %s %.1f %.1f\n", keys[j], stats(a), stats(b),
+            100 * (s0[3] - s1[3]) / s0[3], 100 * (s0[5] - s1[5]) / s0[5]
+    }
+}' $runs > $summary
+
+if command -v column > /dev/null; then
+    column -t $summary
+else
+    cat $summary
+fi
+echo "$runs and $summary were created successfully."
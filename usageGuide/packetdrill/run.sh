@@ -0,0 +1,83 @@
+#!/bin/bash
+# Runs the packetdrill scripts of this directory (or the given ones) against
+# the SUSS of the running kernel and reports which pass. Run it as root on a
+# host where the SUSS of Linux 6.8 is installed; it needs packetdrill and
+# unshare.
+#
+#   sudo bash run.sh
+#   sudo bash run.sh --tolerance 8000 pacing.pkt
+#
+# Each script runs in a network namespace of its own, so its sysctls do not
+# touch the host and the per destination state of SUSS, which is kept per
+# namespace, does not carry over to the next run. The scripts set the module
+# parameters of tcp_suss and tcp_cubic, which are not per namespace; run.sh
+# restores them at the end.
+#
+# The scripts were written by the simulator and have not been run against a
+# kernel yet (see usageGuide/README.md), so a FAIL may be the script's fault.
+
+tolerance=4000
+scripts=()
+
+usage() {
+    cat >&2 <<EOF
+Usage: $0 [options] [SCRIPT...]
+  --tolerance US   how far a packet may be from its time in the script ($tolerance)
+The packetdrill binary is \$PACKETDRILL, or packetdrill in the PATH.
+EOF
+    exit 2
+}
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+    --tolerance) [ -n "$2" ] || usage; tolerance=$2; shift ;;
+    -*) usage ;;
+    *) scripts+=("$1") ;;
+    esac
+    shift
+done
+[ ${#scripts[@]} -gt 0 ] || scripts=("$(dirname "$0")"/*.pkt)
+
+if [ "$(id -u)" -ne 0 ]; then
+    echo "Run $0 as root." >&2
+    exit 2
+fi
+packetdrill=${PACKETDRILL:-packetdrill}
+for tool in $packetdrill unshare; do
+    if ! command -v $tool > /dev/null; then
+        echo "$tool is missing." >&2
+        exit 2
+    fi
+done
+if [ ! -f /sys/module/tcp_suss/parameters/suss ]; then
+    echo "The SUSS of Linux 6.8 is not installed: there is no module tcp_suss." >&2
+    exit 2
+fi
+
+# The writable module parameters (root passes test -w on all), restored on exit
+saved=()
+for p in $(find /sys/module/tcp_suss/parameters /sys/module/tcp_cubic/parameters \
+               -type f -perm -u+w); do
+    saved+=("$p=$(cat $p)")
+done
+cleanup() {
+    for s in "${saved[@]}"; do
+        echo "${s#*=}" > "${s%%=*}"
+    done
+}
+trap cleanup EXIT
+
+failed=0
+for f in "${scripts[@]}"; do
+    remote=198.$((18 + RANDOM % 2)).$((RANDOM % 256)).$((RANDOM % 254 + 1))
+    log=$(unshare -n sh -c 'ip link set lo up && exec "$@"' sh \
+        $packetdrill --bind_port=80 --remote_ip=$remote --tolerance_usecs=$tolerance "$f" 2>&1)
+    if [ $? -eq 0 ]; then
+        echo "PASS $f"
+    else
+        echo "FAIL $f"
+        echo "$log" | sed 's/^/    /'
+        failed=1
+    fi
+done
+exit $failed
@@ -0,0 +1,81 @@
+#!/bin/bash
+# Builds suss_sim, suss_sweep, suss_replay, suss_diff, suss_pkt, suss_lockstep
+# and suss_model in build/.
+# CC and CXX can be set, e.g., CC=clang CXX=clang++, SLOTS, the most threads
+# that suss_sweep, suss_replay and suss_diff can use (default: the number of
+# cores), and MODELFLAGS, the target of the SIMD code of suss_model (default:
+# -march=native). The kernel code is built from sourceCode/linux-6.8 and, for
+# suss_diff, sourceCode/linux-5.19.10.
+
+set -e
+cd "$(dirname "$0")"
+
+CC=${CC:-gcc}
+CXX=${CXX:-g++}
+SLOTS=${SLOTS:-$(nproc)}
+MODELFLAGS=${MODELFLAGS:--march=native}
+src=../../sourceCode/linux-6.8/suss
+src519=../../sourceCode/linux-5.19.10/suss
+cflags="-std=gnu11 -O2 -Wall -Wno-unused-function -Wno-unused-variable -Ishim"
+cflags68="$cflags -I$src -Ibuild"
+cflags519="$cflags -Wno-unused-but-set-variable -DSIM_LINUX_5_19 -I$src519 -Ibuild/linux-5.19.10"
+cxxflags="-std=c++17 -O2 -Wall -pthread"
+
+mkdir -p build/linux-5.19.10
+
+# The SUSS fields of struct tcp_sock, from the tcp.h of each source tree
+sed -n '/suss start block/,/suss end[[:space:]]*block/p' "$src/tcp.h" > build/suss_fields.h
+sed -n '/suss start block/,/suss end[[:space:]]*block/p' "$src519/tcp.h" \
+	> build/linux-5.19.10/suss_fields.h
+
+# One copy of the kernel code of each tree per thread (see sim_slot.h)
+objs=
+pids=
+for ((i = 0; i < SLOTS; i++)); do
+	slot=
+	[ $i -gt 0 ] && slot="-DSIM_SLOT=$i"
+	$CC $cflags68 $slot -c sim_kernel.c -o build/sim_kernel_$i.o &
+	pids="$pids $!"
+	$CC $cflags519 $slot -c sim_kernel.c -o build/sim_kernel_5_19_$i.o &
+	pids="$pids $!"
+	objs="$objs build/sim_kernel_$i.o build/sim_kernel_5_19_$i.o"
+done
+{
+	echo '#include "sim_kernel.h"'
+	for k in 6_8 5_19; do
+		for ((i = 1; i < SLOTS; i++)); do
+			echo "extern const struct sim_kernel sim_kernel_${k}_$i;"
+		done
+		echo "const struct sim_kernel *const sim_kernel_${k}_slots[] = {"
+		echo "	&sim_kernel_$k,"
+		for ((i = 1; i < SLOTS; i++)); do
+			echo "	&sim_kernel_${k}_$i,"
+		done
+		echo '};'
+	done
+	echo "const unsigned int sim_kernel_6_8_nslots = $SLOTS;"
+} > build/sim_slots.c
+$CC $cflags -I. -c build/sim_slots.c -o build/sim_slots.o
+for pid in $pids; do
+	wait $pid
+done
+objs="$objs build/sim_slots.o"
+
+$CXX $cxxflags -c suss_sim.cpp -o build/suss_sim.o
+$CXX $cxxflags -c suss_sweep.cpp -o build/suss_sweep.o
+$CXX $cxxflags -c suss_replay.cpp -o build/suss_replay.o
+$CXX $cxxflags -c suss_diff.cpp -o build/suss_diff.o
+$CXX $cxxflags -c suss_pkt.cpp -o build/suss_pkt.o
+$CXX $cxxflags -c suss_lockstep.cpp -o build/suss_lockstep.o
+$CXX -pthread build/suss_sim.o $objs -o build/suss_sim
+$CXX -pthread build/suss_sweep.o $objs -o build/suss_sweep
+$CXX -pthread build/suss_replay.o $objs -o build/suss_replay
+$CXX -pthread build/suss_diff.o $objs -o build/suss_diff
+$CXX -pthread build/suss_pkt.o $objs -o build/suss_pkt
+$CXX -pthread build/suss_lockstep.o $objs -o build/suss_lockstep
+
+# The model does not run the kernel code
+$CXX $cxxflags -O3 -Wno-psabi $MODELFLAGS suss_model.cpp -o build/suss_model
+
+echo "build/suss_sim, build/suss_sweep ($SLOTS threads), build/suss_replay, build/suss_diff, build/suss_pkt,"
+echo "build/suss_lockstep and build/suss_model were built successfully."
@@ -0,0 +1,80 @@
+#!/bin/bash
+# Checks the simulator and the code it runs, after build.sh. Prints PASS or
+# FAIL for each check, and the output of a failed one. The exit status is 1 if
+# a check failed.
+
+cd "$(dirname "$0")"
+
+out=$(mktemp)
+trap 'rm -f "$out"' EXIT
+failed=0
+
+check()
+{
+	local name=$1
+	shift
+	if "$@" > "$out" 2>&1; then
+		echo "PASS $name"
+	else
+		echo "FAIL $name"
+		sed 's/^/	/' "$out"
+		failed=1
+	fi
+}
+
+# Four flows to one destination reach their blue tails within a few ms. Each
+# of them alone has room for its jump of round 4, all of them do not: the
+# split has to scale them (suss_coord_split). Without it, the four red trains
+# of 560 packets overflow the buffer and about 1400 packets are retransmitted.
+coord_split()
+{
+	local log=$(mktemp) retrans
+
+	build/suss_sim --flows 4 --rate 100 --rtt 100 --size 2m -p suss=1 -r "$log" > "$log.out" || return 1
+	cat "$log.out"
+	retrans=$(sed 's/.*retrans=\([0-9]*\).*/\1/' "$log.out" | awk '{ s += $1 } END { print s }')
+	grep 'Jump is shared by' "$log"
+	grep -q 'Jump is shared by' "$log" && [ "$retrans" -lt 1000 ]
+	local ok=$?
+	rm -f "$log" "$log.out"
+	return $ok
+}
+
+# The example downloads of the usage guide were recorded on linux-5.19.10.
+# Replayed through its code, with the recorded RTT samples and sends, they
+# make every recorded decision.
+replay_example()
+{
+	build/suss_replay --tree linux-5.19.10 ../../usageGuide/example/raw.suss0 \
+		../../usageGuide/example/raw.suss1
+}
+
+# A flow of the simulator, with losses, replays the same through linux-6.8.
+replay_sim()
+{
+	local log=$(mktemp) ok
+
+	build/suss_sim --rate 20 --rtt 100 --size 2m --loss 0.001 -p suss=1 -r "$log" > /dev/null &&
+		build/suss_replay "$log"
+	ok=$?
+	rm -f "$log"
+	return $ok
+}
+
+# suss_controller.hpp decides as tcp_suss.c on every packet sent and every ACK
+# of the flows of suss_lockstep.
+lockstep()
+{
+	build/suss_lockstep > "$out.lockstep"
+	local ok=$?
+	grep -v ' same$' "$out.lockstep"
+	rm -f "$out.lockstep"
+	return $ok
+}
+
+check coord_split coord_split
+check replay_example replay_example
+check replay_sim replay_sim
+check lockstep lockstep
+
+exit $failed
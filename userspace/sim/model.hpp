@@ -0,0 +1,345 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * A round-level model of a SUSS download: the FCT and the end of slow start
+ * that the simulator would give, in a few hundred ns instead of a run.
+ *
+ *	sim::model::batch in;		// one vector per parameter
+ *	in.resize(n);
+ *	... in.rate_mbps[i], in.rtt_ms[i], in.buffer_bdp[i], in.bytes[i], ...
+ *	sim::model::results out;
+ *	sim::model::run(sim::model::config(), in, out);
+ *	... out.fct_us[i], out.exit_cwnd[i]
+ *
+ * Slow start is followed a window per round. Round i sends W_i packets from
+ * t_i; they leave the bottleneck back to back, and their ACKs, one packet time
+ * apart, make the round of W_(i+1). The decisions of tcp_suss.c and
+ * tcp_cubic.c are taken on the ACK train of W_i (kernel round i + 2):
+ *
+ *   - suss_speedup(): round 2 jumps if the min RTT is above 10 ms and IW takes
+ *     less than RTT/4 at the bottleneck, else SUSS is off for the flow. A
+ *     later round jumps while it is below suss_max (up to suss_max_cap on fat
+ *     paths) and 4 W_i (8 W_i for a raise) fits in an RTT. Jumps are made in
+ *     consecutive rounds only. A jump is red_pkt packets on top of the 2 W_i
+ *     of ACK clocking, i.e., W_(i+1) = 4 W_i; none is made if the rest of the
+ *     flow fits in the ACK clocked part, and a shorter red train is still
+ *     paced over the whole pacing duration.
+ *   - suss_cap(): with suss_gradient, the cap is the BDP once the queueing
+ *     delay of the blue trains of two rounds in a row grows. The bursts of
+ *     ACK clocking (two packets per ACK) queue from the first train that has
+ *     enough samples (cwnd >= 16); a paced sender only once W_i exceeds the
+ *     BDP. Jumps go on below the cap, and slow start ends when cwnd passes
+ *     it. Without suss_gradient, the cap of the ACK train equals the one of
+ *     HyStart.
+ *   - HyStart: the ACK train ends slow start at cwnd W_i + BDP/2 once it
+ *     lasts RTT/2 (if SUSS is off, and its ACKs are at most 2 ms apart), the
+ *     delay once the backlog of the previous round exceeds
+ *     clamp(RTT/8, 4 ms, 16 ms).
+ *   - A loss in the round whose backlog overflows the buffer ends slow start
+ *     at beta times cwnd.
+ *
+ * Then CUBIC (with its Reno friendly window) grows to the BDP, and the link
+ * runs at its rate, less the sawtooth if beta times the window that fills
+ * the buffer is below the BDP. Not in the model: random loss, ECN, TLP, the
+ * receiver window, delayed ACKs (but for their effect on the samples) and the
+ * later losses of CUBIC other than through the sawtooth.
+ *
+ * run() evaluates LANES points at a time with vectors of the GNU C vector
+ * extensions, in which every branch is a select, so that the compiler emits
+ * SIMD code for the target (see build.sh).
+ */
+#ifndef SIM_MODEL_HPP
+#define SIM_MODEL_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "sim.hpp"
+
+namespace sim {
+namespace model {
+
+/* What is the same for all points */
+struct config {
+	double mss = 1448;
+	bool paced = false;		/* slow start paced by fq, else ACK clocked bursts */
+	int suss_gradient = 0;		/* module parameters of tcp_suss */
+	int suss_max_cap = 5;
+};
+
+/* The points, a vector per parameter (structure of arrays) */
+struct batch {
+	std::vector<double> rate_mbps;	/* bottleneck rate */
+	std::vector<double> rtt_ms;	/* base RTT */
+	std::vector<double> buffer_bdp;	/* bottleneck buffer, in BDPs */
+	std::vector<double> bytes;	/* flow size */
+	std::vector<double> iw;		/* initial window, packets */
+	std::vector<double> suss;	/* 0 or 1 */
+	std::vector<double> suss_max;
+
+	size_t size() const { return rate_mbps.size(); }
+
+	void resize(size_t n)
+	{
+		rate_mbps.resize(n, 100);
+		rtt_ms.resize(n, 50);
+		buffer_bdp.resize(n, 1);
+		bytes.resize(n, 16 << 20);
+		iw.resize(n, 10);
+		suss.resize(n, 0);
+		suss_max.resize(n, 3);
+	}
+};
+
+/* As flow_result: fct_us from the first packet to the arrival of the last
+ * byte, exit_us and exit_cwnd of the end of slow start (0 if none) */
+struct results {
+	std::vector<double> fct_us;
+	std::vector<double> exit_us;
+	std::vector<double> exit_cwnd;
+	std::vector<double> jumps;
+	std::vector<double> lost;
+
+	void resize(size_t n)
+	{
+		fct_us.resize(n);
+		exit_us.resize(n);
+		exit_cwnd.resize(n);
+		jumps.resize(n);
+		lost.resize(n);
+	}
+};
+
+constexpr int LANES = 8;
+constexpr int MAX_ROUNDS = 64;		/* rounds of slow start */
+
+typedef double vd __attribute__((vector_size(LANES * sizeof(double))));
+typedef decltype(vd{} < vd{}) vm;	/* lanes of all ones or zeros */
+
+inline vd splat(double x)
+{
+	return vd{} + x;
+}
+
+inline vm splat_mask(bool b)
+{
+	return (vm){} - (b ? 1 : 0);
+}
+
+inline vd sel(vm m, vd a, vd b)
+{
+	return (vd)(((vm)a & m) | ((vm)b & ~m));
+}
+
+inline vd vmin(vd a, vd b)
+{
+	return sel(a < b, a, b);
+}
+
+inline vd vmax(vd a, vd b)
+{
+	return sel(a > b, a, b);
+}
+
+inline bool any(vm m)
+{
+	for (int k = 0; k < LANES; k++)
+		if (m[k])
+			return true;
+	return false;
+}
+
+/* The cube root: the exponent divided by 3 as a first guess, then Newton */
+inline vd vcbrt(vd a)
+{
+	vd x = vmax(a, -a);
+	vd y = (vd)((vm)x / 3 + 0x2aa0000000000000LL);
+
+	for (int k = 0; k < 6; k++)
+		y = (2 * y + x / (y * y)) / 3;
+	y = sel(x > 0, y, splat(0));
+	return sel(a < 0, -y, y);
+}
+
+/* CUBIC of tcp_cubic.c: C = 0.4 packets/s^3 (in us), beta = 717/1024, and the
+ * Reno friendly window grows by alpha packets per RTT */
+constexpr double CUBIC_C = 0.4e-18;
+constexpr double CUBIC_BETA = 717 / 1024.0;
+constexpr double CUBIC_ALPHA = 3 * (1 - CUBIC_BETA) / (1 + CUBIC_BETA);
+
+/* Time (us) to deliver m packets from the end of slow start with cwnd w0, the
+ * origin wmax of the cubic and its time k to get there. p is the BDP and qb
+ * the buffer in packets, s the packet time and r the RTT (us). */
+inline vd ca_time(vd m, vd w0, vd wmax, vd k, vd p, vd qb, vd s, vd r)
+{
+	auto delivered = [&](vd x) {	/* packets in x us, window limited */
+		vd xk = x - k, k2 = k * k;
+		vd cubic = (CUBIC_C * (xk * xk * xk * xk - k2 * k2) / 4 + wmax * x) / r;
+		vd reno = (w0 * x + CUBIC_ALPHA * x * x / (2 * r)) / r;
+
+		return vmax(cubic, reno);
+	};
+	/* until cwnd reaches the BDP */
+	vd fill = vmax(vmin(k + vcbrt((p - wmax) / CUBIC_C), (p - w0) * r / CUBIC_ALPHA), splat(0));
+	vd fill_pkts = delivered(fill);
+	vd lo = splat(0), hi = fill;
+
+	for (int n = 0; n < 40 && any(m < fill_pkts); n++) {
+		vd mid = (lo + hi) / 2;
+		vm below = delivered(mid) < m;
+
+		lo = sel(below, mid, lo);
+		hi = sel(below, hi, mid);
+	}
+
+	/* then at the rate of the link, less the sawtooth: on average cwnd is
+	 * (1 - (1 - beta) / 4) of the window that fills the buffer */
+	vd util = vmin(splat(1), (p + qb) * (1 - (1 - CUBIC_BETA) / 4) / p);
+	util = sel(CUBIC_BETA * (p + qb) >= p, splat(1), util);
+	return sel(m <= fill_pkts, hi, fill + (m - fill_pkts) * s / util);
+}
+
+/* Points [off, off + n) of in, n <= LANES */
+inline void run_lanes(const config &cfg, const batch &in, results &out, size_t off, size_t n)
+{
+	const double wire = cfg.mss + HEADER_BYTES;
+	const double inf = 1e300;
+	vd rate, r, qb_bdp, pkts, iw, suss, smax;
+
+	for (int k = 0; k < LANES; k++) {
+		size_t i = off + std::min<size_t>(k, n - 1);	/* pad with the last */
+
+		rate[k] = in.rate_mbps[i] * 1e6;
+		r[k] = in.rtt_ms[i] * 1000;
+		qb_bdp[k] = in.buffer_bdp[i];
+		pkts[k] = std::ceil(in.bytes[i] / cfg.mss);
+		iw[k] = in.iw[i];
+		suss[k] = in.suss[i];
+		smax[k] = in.suss_max[i];
+	}
+
+	vd s = wire * 8 * 1e6 / rate;		/* us per packet at the bottleneck */
+	vd p = r / s;				/* BDP, packets */
+	vd qb = vmax(qb_bdp * p, splat(1));	/* buffer, packets */
+	vd eta = vmin(vmax(r / 8, splat(4000)), splat(16000));
+	vm burst = splat_mask(!cfg.paced);
+	vm on = (suss != 0) & (r > 10000) & (4 * iw * s < r);
+	vm train = (~on | splat_mask(!cfg.suss_gradient)) & (2 * s <= 2000);
+	vm fat = r >= 40000;
+
+	vd t = splat(0), w = iw, d = splat(0), wp = splat(0), jumps = splat(0), cap = splat(0);
+	vd fct = splat(NAN), exit_t = splat(0), exit_w = splat(0), lost = splat(0);
+	vd ca_m = splat(0), ca_w0 = splat(1);	/* packets left and cwnd after the exit */
+	vm active = splat_mask(true), gf = on, jumped = splat_mask(false), qprev = splat_mask(false);
+	vm ca_all = splat_mask(false), ca_loss = splat_mask(false);
+
+	for (int i = 0; i < MAX_ROUNDS && any(active); i++) {
+		vd rem = pkts - d;
+
+		/* The flow ends in this round. The red train of a jump is paced
+		 * over the pacing duration even if the flow needs less of it. */
+		vm fin = active & (rem <= w);
+		vd pacing = r - r / (double)(1ULL << i);
+		vd last = t + sel(jumped & (rem > 2 * wp), vmax(rem * s, pacing), rem * s);
+
+		fct = sel(fin, last + r / 2, fct);
+		active &= ~fin;
+
+		/* The ACK train of W_i, while W_(i+1) is sent. o is the number of
+		 * its packets acked when slow start ends, if it does. */
+		vd tn = t + vmax(r, w * s);
+		vd backlog = vmax(wp - p, splat(0));
+		vd queue = sel(burst, (i ? wp : w) + backlog, vmax(w - p, splat(0)));
+		vm loss = queue > qb;
+		vd drop = sel(burst, 2 * vmax(qb - backlog, splat(0)), vmax(p + qb - wp, splat(0)));
+		vm q = (burst & splat_mask(i > 0) & (iw * (double)(1ULL << i) >= 16)) | (~burst & (w > p));
+		vm capset = on & splat_mask(cfg.suss_gradient) & (cap == 0) & q & qprev;
+
+		cap = sel(capset, vmax(p, w + 8), cap);
+		vd o = sel(backlog * s >= eta, splat(16), splat(inf));
+		o = vmin(o, sel(loss, vmin(drop + 3, w - 1), splat(inf)));
+		o = vmin(o, sel(train & (w * s > r / 2) & (w + p / 2 >= 16), p / 2, splat(inf)));
+		o = vmin(o, sel(cap > 0, vmax(cap + 1 - w, sel(capset, splat(8), splat(1))), splat(inf)));
+
+		vm ex = active & (o < w);
+		vm done = ex & (pkts <= d + w + o);	/* ends before the exit */
+
+		fct = sel(done, tn + (pkts - d - w) * s + r / 2, fct);
+
+		/* The end of slow start, then congestion avoidance */
+		vm ca = ex & ~done;
+		vd cwnd = w + o;
+		vd l = sel(loss, vmin(queue - qb, w), splat(0));
+		vm overflow = ~loss & (cwnd - p > qb);	/* in the next round */
+
+		l = sel(overflow, cwnd - p - qb, l);
+		loss |= overflow;
+		exit_t = sel(ca, tn + o * s, exit_t);
+		exit_w = sel(ca, cwnd, exit_w);
+		lost = sel(ca, l, lost);
+		ca_m = sel(ca, pkts - (d + w + o - l), ca_m);
+		ca_w0 = sel(ca, sel(loss, CUBIC_BETA * cwnd, cwnd), ca_w0);
+		ca_loss = (ca & loss) | (~ca & ca_loss);
+		ca_all |= ca;
+		active &= ~ex;
+
+		/* Else the growth factor of suss_speedup() */
+		vd fi = splat(i);
+		vm speedup = i ? ((fi < smax) & (4 * w * s <= r)) |
+				 (fat & (fi >= smax) & (fi < cfg.suss_max_cap) & (8 * w * s <= r)) :
+				 splat_mask(true);
+		speedup &= gf & ((cap == 0) | (2 * w < cap));
+		gf &= speedup | ~active;
+		jumped = active & speedup & (pkts - d - w > 2 * w);
+		jumps += sel(jumped, splat(1), splat(0));
+		d += w;
+		wp = w;
+		qprev = q;
+		w = sel(jumped, sel(cap > 0, vmin(4 * w, vmax(cap, 2 * w)), 4 * w), 2 * w);
+		t = tn;
+	}
+
+	/* CUBIC after the exit, for all lanes at once; its origin is cwnd at
+	 * the exit, reached k after a loss */
+	if (any(ca_all)) {
+		vd k = sel(ca_loss, vcbrt(exit_w * (1 - CUBIC_BETA) / CUBIC_C), splat(0));
+
+		fct = sel(ca_all, exit_t + ca_time(ca_m, ca_w0, exit_w, k, p, qb, s, r) + r / 2, fct);
+	}
+
+	for (size_t k = 0; k < n; k++) {
+		out.fct_us[off + k] = fct[k];
+		out.exit_us[off + k] = exit_t[k];
+		out.exit_cwnd[off + k] = exit_w[k];
+		out.jumps[off + k] = jumps[k];
+		out.lost[off + k] = lost[k];
+	}
+}
+
+/* Evaluates all points of in on `threads` threads (0: one per core). fct_us is
+ * NaN if slow start did not end in MAX_ROUNDS. */
+inline void run(const config &cfg, const batch &in, results &out, unsigned threads = 1)
+{
+	size_t n = in.size(), blocks = (n + LANES - 1) / LANES;
+	std::vector<std::thread> workers;
+
+	out.resize(n);
+	if (!threads)
+		threads = std::max(1U, std::thread::hardware_concurrency());
+	threads = (unsigned)std::min<size_t>(threads, std::max<size_t>(blocks, 1));
+
+	for (unsigned t = 0; t < threads; t++)
+		workers.emplace_back([&, t] {
+			for (size_t b = blocks * t / threads; b < blocks * (t + 1) / threads; b++)
+				run_lanes(cfg, in, out, b * LANES, std::min<size_t>(LANES, n - b * LANES));
+		});
+	for (std::thread &w : workers)
+		w.join();
+}
+
+} /* namespace model */
+} /* namespace sim */
+
+#endif /* SIM_MODEL_HPP */
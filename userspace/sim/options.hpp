@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * The command line options of a sim::scenario that suss_sim and suss_sweep
+ * share. Errors throw std::invalid_argument.
+ */
+#ifndef SIM_OPTIONS_HPP
+#define SIM_OPTIONS_HPP
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sim.hpp"
+#include "trace_link.hpp"
+
+namespace sim {
+
+constexpr const char *option_help =
+	"  --rate MBIT        bottleneck rate (100)\n"
+	"  --rtt MS           base RTT (50)\n"
+	"  --buffer N[bdp]    bottleneck buffer in bytes, or in BDPs with the suffix (1bdp)\n"
+	"  --loss P           random loss probability at the bottleneck (0)\n"
+	"  --ecn N            CE mark above N BDPs of backlog, ECN negotiated (off)\n"
+	"  --downlink FILE    Mahimahi trace of the bottleneck; sets --rate to its mean\n"
+	"  --uplink FILE      Mahimahi trace of the path of the ACKs (none)\n"
+	"  --nic MBIT         NIC rate of the server (10000)\n"
+	"  --size N[k|m|g]    bytes per flow (16m)\n"
+	"  --flows N          number of flows (1)\n"
+	"  --gap MS           time between the starts of the flows (0)\n"
+	"  --cc NAME          cubic or reno (cubic)\n"
+	"  --mss N            (1448)\n"
+	"  --rwnd N[k|m|g]    receiver window (64m)\n"
+	"  --hint H           how SUSS learns the flow size: none, fin or size (none)\n"
+	"  --quickack N       segments acked at once at the start (16)\n"
+	"  --delack MS        delayed ACK timeout (40)\n"
+	"  --seed N           seed of the random loss (1)\n"
+	"  --time S           stop the run after S seconds (600)\n";
+
+inline double parse_number(const std::string &arg)
+{
+	const char *s = arg.c_str();
+	char *end;
+	double v;
+
+	errno = 0;
+	v = std::strtod(s, &end);
+	if (errno || end == s || *end || v < 0)
+		throw std::invalid_argument("bad number: " + arg);
+	return v;
+}
+
+/* N with an optional k, m or g suffix (powers of 1024) */
+inline u64 parse_bytes(const std::string &arg)
+{
+	std::string s(arg);
+	u64 mul = 1;
+
+	if (!s.empty()) {
+		switch (s.back()) {
+		case 'k': case 'K': mul = 1ULL << 10; break;
+		case 'm': case 'M': mul = 1ULL << 20; break;
+		case 'g': case 'G': mul = 1ULL << 30; break;
+		}
+		if (mul > 1)
+			s.pop_back();
+	}
+	return (u64)(parse_number(s) * mul);
+}
+
+/* N bytes, or N BDPs with the suffix "bdp" */
+inline void parse_buffer(scenario &sc, const std::string &arg)
+{
+	if (arg.size() > 3 && arg.compare(arg.size() - 3, 3, "bdp") == 0) {
+		sc.buffer_bdp = parse_number(arg.substr(0, arg.size() - 3));
+		sc.buffer_bytes = 0;
+	} else {
+		sc.buffer_bytes = parse_bytes(arg);
+	}
+}
+
+/* "name=value" of a module parameter of the kernel of the scenario */
+inline std::pair<std::string, int> parse_param(const scenario &sc, const std::string &arg)
+{
+	size_t eq = arg.find('=');
+	std::string name = arg.substr(0, eq);
+	int v;
+
+	if (eq == std::string::npos || sc.kernel->param(name.c_str(), &v, 0))
+		throw std::invalid_argument("no module parameter " + name);
+	return { name, std::atoi(arg.c_str() + eq + 1) };
+}
+
+/* Returns false if opt is not an option of option_help */
+inline bool parse_option(scenario &sc, const std::string &opt, const std::string &arg)
+{
+	if (opt == "--rate") {
+		sc.rate_mbps = parse_number(arg);
+	} else if (opt == "--rtt") {
+		sc.rtt_ms = parse_number(arg);
+	} else if (opt == "--buffer") {
+		parse_buffer(sc, arg);
+	} else if (opt == "--loss") {
+		sc.loss = parse_number(arg);
+	} else if (opt == "--ecn") {
+		sc.ecn_bdp = parse_number(arg);
+	} else if (opt == "--downlink") {
+		sc.rate_mbps = trace_link::mean_rate(arg) / 1e6;
+		sc.make_link = [arg](const scenario &sc) {
+			return std::make_unique<trace_link>(arg, sc.buffer(), sc.loss,
+							    (u64)(sc.ecn_bdp * sc.bdp_bytes()), sc.seed);
+		};
+	} else if (opt == "--uplink") {
+		trace_link::mean_rate(arg);
+		sc.make_ack_link = [arg](const scenario &) {
+			return std::make_unique<trace_link>(arg, UINT64_MAX, 0, 0, 0);
+		};
+	} else if (opt == "--nic") {
+		sc.nic_mbps = parse_number(arg);
+	} else if (opt == "--size") {
+		sc.bytes = parse_bytes(arg);
+	} else if (opt == "--flows") {
+		sc.flows = (u32)parse_number(arg);
+	} else if (opt == "--gap") {
+		sc.gap_ms = parse_number(arg);
+	} else if (opt == "--cc") {
+		sc.cc = arg;
+	} else if (opt == "--mss") {
+		sc.mss = (u32)parse_number(arg);
+	} else if (opt == "--rwnd") {
+		sc.rwnd = (u32)parse_bytes(arg);
+	} else if (opt == "--hint") {
+		if (arg == "none")
+			sc.size_hint = SIM_HINT_NONE;
+		else if (arg == "fin")
+			sc.size_hint = SIM_HINT_FIN;
+		else if (arg == "size")
+			sc.size_hint = SIM_HINT_SIZE;
+		else
+			throw std::invalid_argument("bad hint: " + arg);
+	} else if (opt == "--quickack") {
+		sc.quickack = (u32)parse_number(arg);
+	} else if (opt == "--delack") {
+		sc.delack_ms = parse_number(arg);
+	} else if (opt == "--seed") {
+		sc.seed = (u64)parse_number(arg);
+	} else if (opt == "--time") {
+		sc.time_s = parse_number(arg);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/* A list of values: "a,b,c", "lo:hi:xF" (lo, lo * F, ... up to hi) or
+ * "lo:hi:+S" (lo, lo + S, ... up to hi); parse() reads each number */
+inline std::vector<double> parse_values(const std::string &arg,
+					u64 (*parse)(const std::string &) = nullptr)
+{
+	auto num = [&](const std::string &s) {
+		return parse ? (double)parse(s) : parse_number(s);
+	};
+	std::vector<double> v;
+	size_t c1 = arg.find(':');
+
+	if (c1 != std::string::npos) {
+		size_t c2 = arg.find(':', c1 + 1);
+		double lo, hi, step;
+		bool mul;
+
+		if (c2 == std::string::npos || c2 + 1 >= arg.size() ||
+		    (arg[c2 + 1] != 'x' && arg[c2 + 1] != '+'))
+			throw std::invalid_argument("bad range: " + arg);
+		lo = num(arg.substr(0, c1));
+		hi = num(arg.substr(c1 + 1, c2 - c1 - 1));
+		mul = arg[c2 + 1] == 'x';
+		step = parse_number(arg.substr(c2 + 2));
+		if (mul ? step <= 1 || lo <= 0 : step <= 0)
+			throw std::invalid_argument("bad range: " + arg);
+		/* The steps are counted, so that rounding does not lose hi */
+		for (u64 k = 0;; k++) {
+			double x = mul ? lo * std::pow(step, (double)k) : lo + step * k;
+
+			if (x > hi * (1 + 1e-9))
+				break;
+			v.push_back(x);
+		}
+		return v;
+	}
+
+	for (size_t pos = 0;;) {
+		size_t comma = arg.find(',', pos);
+
+		v.push_back(num(arg.substr(pos, comma - pos)));
+		if (comma == std::string::npos)
+			break;
+		pos = comma + 1;
+	}
+	return v;
+}
+
+/* Throws if the scenario cannot be run */
+inline void check_scenario(const scenario &sc)
+{
+	if (!sc.flows || !sc.mss || !sc.bytes || sc.bytes > UINT32_MAX / 2 ||
+	    sc.rate_mbps <= 0 || sc.nic_mbps <= 0)
+		throw std::invalid_argument("bad scenario");
+}
+
+} /* namespace sim */
+
+#endif /* SIM_OPTIONS_HPP */
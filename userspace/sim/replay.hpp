@@ -0,0 +1,524 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Replay of recorded SUSSmsg traces through the kernel code of sim_kernel.c.
+ *
+ *	std::vector<sim::replay::trace> rec = sim::replay::read_log(in);
+ *	sim::replay::trace out = sim::replay::run(&sim_kernel_6_8, rec[0], opts);
+ *	sim::replay::diff d = sim::replay::compare(rec[0], out, 0.05);
+ *
+ * A trace is what the SUSSmsg lines of one flow tell: an ACK line (SUSSmsg@)
+ * per ACK that reached cong_avoid, and the decisions printed in between. The
+ * replay connects a sender at the time the initial window left (the first ACK
+ * less its min RTT), and gives it the recorded ACKs at their recorded times:
+ * the ACK of a line acks up to its d (snd_una), and an ACK that does not
+ * move d SACKs the segment after the highest one SACKed so far, i.e., a loss
+ * is taken as the first hole. The ACKs of a recovery have no lines, so the
+ * replay SACKs three segments at the time and d of each "cwnd reduction"
+ * line, which starts the recovery as RACK does. The sender transmits, paces
+ * and fires its RTO on its own, with two things of the recorded sender that
+ * its send times do not give (see struct sim_ack): the RTT sample of each
+ * ACK is the one that takes srtt to the recorded RTT, and until the first
+ * loss it sends no more before the next ACK than the recorded sender had
+ * sent by then (d and i of the next line), as TSO and TSQ held back part of
+ * what cwnd let go. The line of the ACK of the FIN has no pair, as the
+ * sender of the replay sends none.
+ *
+ * The decisions that are compared are the round starts (round, cwnd), the
+ * growth factors (G), the pacing plans (packets, limit, rate, duration), the
+ * caps, the exits from slow start (type, cwnd) and the starts of recoveries
+ * and RTOs (cwnd). The ACK lines are paired by their time and compared on c,
+ * s and Rnd.
+ */
+#ifndef SIM_REPLAY_HPP
+#define SIM_REPLAY_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sim.hpp"
+
+namespace sim {
+namespace replay {
+
+/* A SUSSmsg@ line */
+struct ack_line {
+	u64 t_us;		/* tcp_mstamp */
+	u32 cwnd;		/* c */
+	u32 inflight;		/* i */
+	u32 acked;		/* a */
+	u32 srtt_us;		/* RTT */
+	u32 min_rtt_us;		/* minRTT */
+	u32 una;		/* d, bytes from the ISN */
+	u32 lost;		/* l */
+	u32 state;		/* s, suss_state */
+	u32 round;		/* Rnd */
+};
+
+enum kind : u8 { ROUND, GROWTH, PACE, CAP, EXIT, LOSS };
+
+/* A decision, on the ACK of acks[ack] (or after the last one) */
+struct decision {
+	kind k;
+	size_t ack;
+	u64 v[4];	/* round: round, cwnd; G: G; pace: packets, limit, rate
+			 * (Bps), duration (us); cap: cap; exit: type, cwnd; loss:
+			 * cwnd, 1 for a recovery or 2 for an RTO */
+};
+
+/* The start of a recovery: its time and d */
+struct recovery {
+	u64 t_us;
+	u32 una;
+};
+
+struct trace {
+	u32 id = 0;
+	u32 sport = 0;
+	std::vector<ack_line> acks;
+	std::vector<decision> decisions;
+	std::vector<recovery> recoveries;
+
+	/* Time of a decision, in us from the first ACK */
+	double time_us(const decision &d) const
+	{
+		if (acks.empty())
+			return 0;
+		return (double)(acks[std::min(d.ack, acks.size() - 1)].t_us - acks[0].t_us);
+	}
+};
+
+/* The number after " key=" in s, and whether there is one */
+inline bool field(const char *s, const char *key, u64 &v)
+{
+	std::string k = std::string(" ") + key + "=";
+	const char *p = std::strstr(s, k.c_str());
+	char *end;
+
+	if (!p)
+		return false;
+	p += k.size();
+	v = std::strtoull(p, &end, 10);
+	return end != p;
+}
+
+/* Adds a line of kern.log (or of suss_sim -r) to the trace of its flow;
+ * other lines are skipped. `index` maps ids to traces. */
+inline void add_line(std::vector<trace> &traces, std::map<u32, size_t> &index, const char *line)
+{
+	const char *p = std::strstr(line, "SUSSmsg");
+	bool ack;
+	u64 id, v;
+
+	if (!p)
+		return;
+	p += std::strlen("SUSSmsg");
+	ack = *p == '@';
+	if (ack)
+		p++;
+	if (!field(p, "id", id))
+		return;
+
+	auto it = index.find((u32)id);
+	if (it == index.end()) {
+		it = index.emplace((u32)id, traces.size()).first;
+		traces.emplace_back();
+		traces.back().id = (u32)id;
+	}
+	trace &tr = traces[it->second];
+	if (field(p, "Sport", v))
+		tr.sport = (u32)v;
+
+	if (ack) {
+		ack_line a = {};
+		u64 x[10];
+		static const char *const keys[] = {
+			"t", "c", "i", "a", "RTT", "minRTT", "d", "l", "s", "Rnd",
+		};
+
+		for (size_t k = 0; k < std::size(keys); k++)
+			if (!field(p, keys[k], x[k]))
+				return;
+		a = { x[0], (u32)x[1], (u32)x[2], (u32)x[3], (u32)x[4], (u32)x[5],
+		      (u32)x[6], (u32)x[7], (u32)x[8], (u32)x[9] };
+		tr.acks.push_back(a);
+		return;
+	}
+
+	decision d = { ROUND, tr.acks.size(), {} };
+	unsigned long long a, b, c;
+	u64 t, una;
+	const char *msg = std::strchr(p + 1, ' ');
+
+	if (!msg)
+		return;
+	msg++;
+	if (std::sscanf(msg, "New round %llu is started.", &a) == 1 && field(msg, "c", v)) {
+		d.k = ROUND;
+		d.v[0] = a;
+		d.v[1] = v;
+	} else if (!std::strncmp(msg, "Growth factor", 13) && field(msg, "G", v)) {
+		d.k = GROWTH;
+		d.v[0] = v;
+	} else if (std::sscanf(msg, "Total amount of %llu packets is paced in %llu microSec with rate %llu Bps",
+			       &a, &b, &c) == 3 && field(msg, "limit", v)) {
+		d.k = PACE;
+		d.v[0] = a;
+		d.v[1] = v;
+		d.v[2] = c;
+		d.v[3] = b;
+	} else if (!std::strncmp(msg, "Cap is set:", 11) && field(msg, "cap", v)) {
+		d.k = CAP;
+		d.v[0] = v;
+	} else if (std::sscanf(msg, "Stop exponential growth (type=%llu)", &a) == 1 &&
+		   field(msg, "c", v)) {
+		d.k = EXIT;
+		d.v[0] = a;
+		d.v[1] = v;
+	} else if (!std::strncmp(msg, "cwnd reduction.", 15) && field(msg, "cwnd", v) &&
+		   field(msg, "t", t) && field(msg, "d", una)) {
+		d.k = LOSS;
+		d.v[0] = v;
+		d.v[1] = 1;
+		tr.recoveries.push_back({ t, (u32)una });
+	} else if (!std::strncmp(msg, "Entered loss state.", 19) && field(msg, "cwnd", v)) {
+		d.k = LOSS;
+		d.v[0] = v;
+		d.v[1] = 2;
+	} else {
+		return;
+	}
+	tr.decisions.push_back(d);
+}
+
+/* The traces of the flows of a kern.log, in the order of their first line */
+inline std::vector<trace> read_log(std::istream &in)
+{
+	std::vector<trace> traces;
+	std::map<u32, size_t> index;
+	std::string line;
+
+	while (std::getline(in, line))
+		add_line(traces, index, line.c_str());
+	traces.erase(std::remove_if(traces.begin(), traces.end(),
+				    [](const trace &tr) { return tr.acks.empty(); }),
+		     traces.end());
+	return traces;
+}
+
+struct options {
+	std::string cc = "cubic";
+	u32 mss = 0;		/* 0: from the first ACK line */
+	u32 rwnd = 64 << 20;
+	std::vector<std::pair<std::string, int>> params;	/* module parameters */
+};
+
+/* The size of the flow: the largest d, less the FIN if the ACK before acked
+ * one byte less */
+inline u32 flow_bytes(const trace &rec)
+{
+	u32 max = 0, prev = 0;
+
+	for (const ack_line &a : rec.acks) {
+		if (a.una > max) {
+			prev = max;
+			max = a.una;
+		}
+	}
+	return prev + 1 == max ? prev : max;
+}
+
+inline u32 flow_mss(const trace &rec, const options &opt)
+{
+	if (opt.mss)
+		return opt.mss;
+	for (const ack_line &a : rec.acks)
+		if (a.una && a.acked)
+			return std::max(1U, a.una / a.acked);
+	return 1448;
+}
+
+/* Whether the recorded flow ran SUSS: it started rounds or was in a state
+ * of SUSS below 10 */
+inline bool uses_suss(const trace &rec)
+{
+	for (const decision &d : rec.decisions)
+		if (d.k == ROUND)
+			return true;
+	for (const ack_line &a : rec.acks)
+		if (a.state && a.state < 10)
+			return true;
+	return false;
+}
+
+/* Replays rec through kernel k, whose module state it resets, and returns
+ * the trace of the replay. The module parameter suss follows the recording
+ * unless opt sets it. `unsent` counts the ACKs of data that the replay had
+ * not sent yet. */
+inline trace run(const sim_kernel *k, const trace &rec, const options &opt, u32 *unsent = nullptr)
+{
+	trace out;
+	std::map<u32, size_t> index;
+	u32 mss = flow_mss(rec, opt), bytes = flow_bytes(rec);
+	u32 segs = (bytes + mss - 1) / mss;
+	u32 sent = 0, sack_hi = 0, prev_cum = 0, n = 0;
+	u64 pace_at = 0;
+	sim_conn conn = {};
+	bool suss_set = false;
+
+	if (rec.acks.empty() || !bytes)
+		return out;
+	for (const auto &p : opt.params) {
+		int v = p.second;
+
+		k->param(p.first.c_str(), &v, 1);
+		suss_set |= p.first == "suss";
+	}
+	if (!suss_set) {
+		int v = uses_suss(rec);
+
+		k->param("suss", &v, 1);
+	}
+	k->load();
+
+	std::vector<trace> traces;
+	auto on_log = [&](const char *msg) { add_line(traces, index, msg); };
+	k->log([](void *ctx, const char *msg) {
+		(*static_cast<decltype(on_log) *>(ctx))(msg);
+	}, &on_log);
+
+	auto on_emit = [&](const sim_seg *seg) { sent = std::max(sent, seg->idx + 1); };
+	auto emit = [](void *ctx, const sim_seg *seg) {
+		(*static_cast<decltype(on_emit) *>(ctx))(seg);
+	};
+
+	const ack_line &first = rec.acks[0];
+	u64 start_ns = (first.t_us - std::min<u64>(first.min_rtt_us, first.t_us)) * NSEC_PER_USEC;
+
+	conn.cc = opt.cc.c_str();
+	conn.mss = mss;
+	conn.bytes = bytes;
+	conn.rwnd = opt.rwnd;
+	/* The first ACK acks one segment, whose sample is minRTT: the handshake
+	 * RTT is the one that srtt then moved from */
+	conn.syn_rtt_us = first.min_rtt_us;
+	if (first.acked == 1 && first.srtt_us)
+		conn.syn_rtt_us = (u32)std::max<long long>(1, ((long long)first.srtt_us * 8 + 4 -
+							   first.min_rtt_us) / 7);
+	conn.daddr = 0x0100000a;
+	conn.sport = (u16)rec.sport;
+	conn.dport = 0x1000;
+	conn.size_hint = SIM_HINT_FIN;
+	sim_sock *s = k->connect(&conn, start_ns);
+	if (!s) {
+		k->log(nullptr, nullptr);
+		return out;
+	}
+	pace_at = k->write_xmit(s, start_ns, emit, &on_emit);
+
+	/* An ACK at now: the timers of the sender that are due before it, the
+	 * ACK, and what the sender then sends */
+	auto deliver = [&](u64 now, u32 cum, u32 sack, u32 srtt_us, u32 nxt) {
+		sim_ack ack = { cum, sack, 0, srtt_us, nxt };
+
+		for (;;) {
+			u64 rto = k->rto_time(s);
+			u64 t = std::min(pace_at ? pace_at : UINT64_MAX, rto ? rto : UINT64_MAX);
+
+			if (t >= now)
+				break;
+			if (rto && rto == t)
+				k->rto(s, t);
+			pace_at = k->write_xmit(s, t, emit, &on_emit);
+		}
+		if (cum > sent || (sack != UINT32_MAX && sack >= sent))
+			n++;
+		k->ack(s, now, &ack);
+		pace_at = k->write_xmit(s, now, emit, &on_emit);
+	};
+	/* The next segment to SACK above cum, or UINT32_MAX */
+	auto next_sack = [&](u32 cum) {
+		sack_hi = std::max(sack_hi, cum) + 1;
+		return sack_hi < segs ? sack_hi : UINT32_MAX;
+	};
+
+	/* The ACK lines, and three SACKs at the start of each recovery (the
+	 * ACKs in a recovery do not reach cong_avoid, so they have no line) */
+	size_t r = 0;
+	for (size_t l = 0; l < rec.acks.size(); l++) {
+		const ack_line &a = rec.acks[l];
+		for (; r < rec.recoveries.size() && rec.recoveries[r].t_us < a.t_us; r++) {
+			u32 cum = std::min<u32>(segs, (rec.recoveries[r].una + mss - 1) / mss);
+
+			for (int i = 0; i < 3; i++)
+				deliver(rec.recoveries[r].t_us * NSEC_PER_USEC, cum, next_sack(cum), 0, 0);
+			prev_cum = cum;
+		}
+
+		u32 cum = std::min<u32>(segs, (a.una + mss - 1) / mss);
+		u32 sack = UINT32_MAX;
+
+		if (cum == prev_cum && a.acked && cum < segs)
+			sack = next_sack(cum);
+		prev_cum = cum;
+		/* What the recorded sender had sent when the next ACK came: the
+		 * segments acked by it and those in flight, while none was lost */
+		u32 nxt = 0;
+		if (l + 1 < rec.acks.size() && !rec.acks[l + 1].lost) {
+			const ack_line &b = rec.acks[l + 1];
+
+			nxt = std::max(cum + 1, (b.una + mss - 1) / mss + b.inflight);
+		}
+		deliver(a.t_us * NSEC_PER_USEC, cum, sack, a.srtt_us, nxt);
+	}
+	k->close(s);
+	k->log(nullptr, nullptr);
+
+	if (unsent)
+		*unsent = n;
+	if (!traces.empty())
+		out = traces[0];
+	return out;
+}
+
+/* Whether a and b are equal within the relative tolerance tol */
+inline bool near(u64 a, u64 b, double tol)
+{
+	return std::fabs((double)a - (double)b) <= tol * (double)std::max(a, b);
+}
+
+inline bool same(const decision &a, const decision &b, double tol)
+{
+	if (a.k != b.k)
+		return false;
+	switch (a.k) {
+	case ROUND:
+		return a.v[0] == b.v[0] && near(a.v[1], b.v[1], tol);
+	case GROWTH:
+		return a.v[0] == b.v[0];
+	case PACE:
+		return near(a.v[0], b.v[0], tol) && near(a.v[1], b.v[1], tol) &&
+		       near(a.v[2], b.v[2], tol) && near(a.v[3], b.v[3], tol);
+	case CAP:
+		return near(a.v[0], b.v[0], tol);
+	case LOSS:
+		return a.v[1] == b.v[1] && near(a.v[0], b.v[0], tol);
+	case EXIT:
+		return a.v[0] == b.v[0] && near(a.v[1], b.v[1], tol);
+	}
+	return false;
+}
+
+/* The first differences of a replay from its recording */
+struct diff {
+	size_t decision = SIZE_MAX;	/* index of the first decision that differs */
+	size_t matched = 0;		/* decisions that are the same */
+	size_t ack = SIZE_MAX;		/* index in rec.acks of the first ACK line that differs */
+	size_t unpaired = 0;		/* ACK lines of either side without a pair */
+
+	bool ok() const { return decision == SIZE_MAX && ack == SIZE_MAX && !unpaired; }
+};
+
+inline diff compare(const trace &rec, const trace &out, double tol)
+{
+	diff d;
+	size_t n = std::min(rec.decisions.size(), out.decisions.size());
+	size_t i = 0, j = 0, nrec = rec.acks.size();
+
+	/* The sender of the replay sends no FIN: the line of the ACK of the
+	 * recorded one has no pair */
+	if (nrec > 1 && rec.acks[nrec - 1].una == flow_bytes(rec) + 1)
+		nrec--;
+
+	for (; d.matched < n; d.matched++)
+		if (!same(rec.decisions[d.matched], out.decisions[d.matched], tol))
+			break;
+	if (d.matched < std::max(rec.decisions.size(), out.decisions.size()))
+		d.decision = d.matched;
+
+	/* ACK lines of the same time, in order */
+	while (i < nrec && j < out.acks.size()) {
+		const ack_line &a = rec.acks[i], &b = out.acks[j];
+
+		if (a.t_us < b.t_us) {
+			d.unpaired++;
+			i++;
+		} else if (b.t_us < a.t_us) {
+			d.unpaired++;
+			j++;
+		} else {
+			if (d.ack == SIZE_MAX && (!near(a.cwnd, b.cwnd, tol) || a.state != b.state ||
+						  a.round != b.round))
+				d.ack = i;
+			i++;
+			j++;
+		}
+	}
+	d.unpaired += nrec - i + out.acks.size() - j;
+	return d;
+}
+
+/* "round 3 c=40", "pace 120 limit=160 rate=4634835 dur=37490", ... */
+inline std::string describe(const decision &d)
+{
+	char buf[128];
+
+	switch (d.k) {
+	case ROUND:
+		std::snprintf(buf, sizeof(buf), "round %llu c=%llu", (unsigned long long)d.v[0],
+			      (unsigned long long)d.v[1]);
+		break;
+	case GROWTH:
+		std::snprintf(buf, sizeof(buf), "G=%llu", (unsigned long long)d.v[0]);
+		break;
+	case PACE:
+		std::snprintf(buf, sizeof(buf), "pace %llu limit=%llu rate=%llu dur=%llu",
+			      (unsigned long long)d.v[0], (unsigned long long)d.v[1],
+			      (unsigned long long)d.v[2], (unsigned long long)d.v[3]);
+		break;
+	case CAP:
+		std::snprintf(buf, sizeof(buf), "cap=%llu", (unsigned long long)d.v[0]);
+		break;
+	case EXIT:
+		std::snprintf(buf, sizeof(buf), "exit type=%llu c=%llu", (unsigned long long)d.v[0],
+			      (unsigned long long)d.v[1]);
+		break;
+	case LOSS:
+		std::snprintf(buf, sizeof(buf), "%s c=%llu", d.v[1] == 2 ? "rto" : "recovery",
+			      (unsigned long long)d.v[0]);
+		break;
+	}
+	return buf;
+}
+
+/* The decisions of a and b side by side, '*' where they differ */
+inline void print_decisions(std::FILE *f, const trace &a, const trace &b, double tol,
+			    const char *name_a, const char *name_b)
+{
+	size_t n = std::max(a.decisions.size(), b.decisions.size());
+
+	std::fprintf(f, "  %9s  %-44s %9s  %s\n", "ms", name_a, "ms", name_b);
+	for (size_t i = 0; i < n; i++) {
+		bool ha = i < a.decisions.size(), hb = i < b.decisions.size();
+
+		std::fprintf(f, "%c %9.1f  %-44s %9.1f  %s\n",
+			     ha && hb && same(a.decisions[i], b.decisions[i], tol) ? ' ' : '*',
+			     ha ? a.time_us(a.decisions[i]) / 1e3 : 0.0,
+			     ha ? describe(a.decisions[i]).c_str() : "-",
+			     hb ? b.time_us(b.decisions[i]) / 1e3 : 0.0,
+			     hb ? describe(b.decisions[i]).c_str() : "-");
+	}
+}
+
+} /* namespace replay */
+} /* namespace sim */
+
+#endif /* SIM_REPLAY_HPP */
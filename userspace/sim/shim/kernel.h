@@ -0,0 +1,584 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * The part of the kernel that tcp_suss.c and tcp_cubic.c use, for compiling
+ * them in user space (see sim_kernel.c). The headers they include (e.g.,
+ * <net/tcp.h>) all come here.
+ *
+ * struct tcp_sock has the fields of the TCP core that the two files and the
+ * sender of sim_kernel.c use; its SUSS fields are the suss block of the tcp.h
+ * of the source tree, which build.sh copies to suss_fields.h, so they cannot
+ * drift apart. The helpers (tcp_slow_start, minmax_running_min, ...) are the
+ * ones of the kernel. Everything is static: sim_kernel.c is the only
+ * translation unit that includes this file.
+ */
+#ifndef SIM_SHIM_KERNEL_H
+#define SIM_SHIM_KERNEL_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t			u8;
+typedef uint16_t		u16;
+typedef uint32_t		u32;
+typedef unsigned long long	u64;
+typedef int8_t			s8;
+typedef int16_t			s16;
+typedef int32_t			s32;
+typedef long long		s64;
+
+/* Module, init and export annotations */
+#define __init
+#define __exit
+#define __read_mostly
+#define __force
+#define __bpf_kfunc
+#define THIS_MODULE			NULL
+#define EXPORT_SYMBOL_GPL(sym)		extern __typeof__(sym) sym
+#define module_param(name, type, perm)	extern __typeof__(name) name
+#define MODULE_PARM_DESC(name, desc)	extern __typeof__(name) name
+#define MODULE_AUTHOR(x)		extern int sim_module_info
+#define MODULE_LICENSE(x)		extern int sim_module_info
+#define MODULE_DESCRIPTION(x)		extern int sim_module_info
+#define MODULE_VERSION(x)		extern int sim_module_info
+/* sim_kernel.c calls the init functions itself (see sim_load) */
+#define module_init(fn)			extern int sim_module_info
+#define module_exit(fn)			static void (*const sim_exit_##fn)(void) __attribute__((unused)) = fn
+#define fs_initcall(fn)			extern int sim_module_info
+#define BUILD_BUG_ON(cond)		_Static_assert(!(cond), #cond)
+#define ARRAY_SIZE(a)			(sizeof(a) / sizeof((a)[0]))
+#define IS_ENABLED(option)		0
+
+/* printk goes to the log of the simulator, pr_debug nowhere */
+#define KERN_INFO			""
+static void sim_printk(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+#define printk(...)			sim_printk(__VA_ARGS__)
+#define pr_debug(...)			do { } while (0)
+
+#define likely(x)			__builtin_expect(!!(x), 1)
+#define unlikely(x)			__builtin_expect(!!(x), 0)
+#define READ_ONCE(x)			(x)
+#define WRITE_ONCE(x, val)		((x) = (val))
+#define WARN_ON_ONCE(cond)		(cond)
+
+#define min(x, y)	({ __typeof__(x) _x = (x); __typeof__(y) _y = (y); _x < _y ? _x : _y; })
+#define max(x, y)	({ __typeof__(x) _x = (x); __typeof__(y) _y = (y); _x > _y ? _x : _y; })
+#define min_t(type, x, y)		min((type)(x), (type)(y))
+#define max_t(type, x, y)		max((type)(x), (type)(y))
+#define min3(x, y, z)			min(min(x, y), z)
+#define clamp(val, lo, hi)		min(max(val, lo), hi)
+#define clamp_t(type, val, lo, hi)	min_t(type, max_t(type, val, lo), hi)
+#define DIV_ROUND_UP(n, d)		(((n) + (d) - 1) / (d))
+
+#define U8_MAX		((u8)~0U)
+#define U32_MAX		((u32)~0U)
+#define HZ		1000
+#define USEC_PER_MSEC	1000UL
+#define USEC_PER_SEC	1000000UL
+#define NSEC_PER_USEC	1000UL
+#define NSEC_PER_MSEC	1000000UL
+#define NSEC_PER_SEC	1000000000ULL
+
+/* linux/math64.h */
+#define do_div(n, base)	({ u32 __base = (base); u32 __rem = (n) % __base; (n) /= __base; __rem; })
+static inline u64 div_u64(u64 dividend, u32 divisor) { return dividend / divisor; }
+static inline u64 div64_u64(u64 dividend, u64 divisor) { return dividend / divisor; }
+static inline s64 div64_s64(s64 dividend, s64 divisor) { return dividend / divisor; }
+static inline s64 div64_long(s64 dividend, long divisor) { return dividend / divisor; }
+static inline u64 div64_ul(u64 dividend, unsigned long divisor) { return dividend / divisor; }
+static inline int fls(u32 x) { return x ? 32 - __builtin_clz(x) : 0; }
+static inline int fls64(u64 x) { return x ? 64 - __builtin_clzll(x) : 0; }
+
+/* linux/hash.h */
+#define GOLDEN_RATIO_32	0x61C88647
+static inline u32 hash_32(u32 val, unsigned int bits) { return (val * GOLDEN_RATIO_32) >> (32 - bits); }
+
+/* Time: the simulator sets the clocks before it calls into the kernel code */
+static unsigned long jiffies;
+static u32 tcp_jiffies32;
+#define time_after_eq(a, b)	((long)((a) - (b)) >= 0)
+#define time_before(a, b)	((long)((a) - (b)) < 0)
+static inline unsigned long msecs_to_jiffies(const unsigned int m) { return m * HZ / 1000; }
+static inline unsigned long usecs_to_jiffies(const unsigned int u) { return u / (USEC_PER_SEC / HZ); }
+
+/* One CPU, no preemption: locks and atomics are plain accesses */
+typedef int spinlock_t;
+#define DEFINE_SPINLOCK(lock)	spinlock_t lock __attribute__((unused))
+#define spin_lock_init(lock)	do { } while (0)
+#define spin_lock_bh(lock)	do { } while (0)
+#define spin_unlock_bh(lock)	do { } while (0)
+#define cmpxchg(ptr, old, new)	({ __typeof__(*(ptr)) __prev = *(ptr); if (__prev == (old)) *(ptr) = (new); __prev; })
+typedef struct { s64 counter; } atomic64_t;
+static inline s64 atomic64_read(const atomic64_t *v) { return v->counter; }
+static inline void atomic64_sub(s64 i, atomic64_t *v) { v->counter -= i; }
+static inline s64 atomic64_cmpxchg(atomic64_t *v, s64 old, s64 new) { return cmpxchg(&v->counter, old, new); }
+
+/* get_random_bytes: a counter, so that the message ids of the flows of a run differ */
+static u32 sim_random;
+static inline void get_random_bytes(void *buf, int nbytes)
+{
+	u32 r = sim_random++;
+
+	memcpy(buf, &r, min_t(int, nbytes, sizeof(r)));
+}
+
+/* net/net_namespace.h, net/netns/generic.h: one netns, init_net. The
+ * subsystems are registered again by each load (see sim_pernet_reset). */
+struct net { int sim_unused; };
+static struct net init_net;
+#define __net_init
+#define __net_exit
+static inline bool net_eq(const struct net *net1, const struct net *net2) { return net1 == net2; }
+struct pernet_operations {
+	int		(*init)(struct net *net);
+	void		(*exit)(struct net *net);
+	unsigned int	*id;
+	size_t		size;
+};
+#define SIM_NET_IDS	4
+static void *sim_net_storage[SIM_NET_IDS];
+static unsigned int sim_net_ids;
+static inline int register_pernet_subsys(struct pernet_operations *ops)
+{
+	void *data;
+
+	if (sim_net_ids == SIM_NET_IDS || !(data = calloc(1, ops->size)))
+		return -ENOMEM;
+	*ops->id = sim_net_ids;
+	sim_net_storage[sim_net_ids++] = data;
+	return ops->init ? ops->init(&init_net) : 0;
+}
+static inline void unregister_pernet_subsys(struct pernet_operations *ops)
+{
+	if (ops->exit)
+		ops->exit(&init_net);
+}
+static inline void *net_generic(const struct net *net, unsigned int id) { return sim_net_storage[id]; }
+
+/* linux/sysctl.h: the sysctls of the netns are set with sim_sysctl */
+struct ctl_table {
+	const char	*procname;
+	void		*data;
+	int		maxlen;
+	unsigned short	mode;
+	int		(*proc_handler)(void);
+	void		*extra1;
+	void		*extra2;
+};
+struct ctl_table_header {
+	struct ctl_table	*ctl_table_arg;
+	size_t			size;
+};
+static const int sim_sysctl_vals[] = { -1, 0, 1 };
+#define SYSCTL_NEG_ONE	((void *)&sim_sysctl_vals[0])
+#define SYSCTL_ZERO	((void *)&sim_sysctl_vals[1])
+#define SYSCTL_ONE	((void *)&sim_sysctl_vals[2])
+static inline int proc_dointvec_minmax(void) { return 0; }
+static struct ctl_table_header sim_sysctl_tables[SIM_NET_IDS];
+static inline struct ctl_table_header *register_net_sysctl_sz(struct net *net, const char *path,
+							       struct ctl_table *table, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < SIM_NET_IDS; i++) {
+		if (!sim_sysctl_tables[i].ctl_table_arg) {
+			sim_sysctl_tables[i].ctl_table_arg = table;
+			sim_sysctl_tables[i].size = size;
+			return &sim_sysctl_tables[i];
+		}
+	}
+	return NULL;
+}
+static inline void unregister_net_sysctl_table(struct ctl_table_header *header)
+{
+	header->ctl_table_arg = NULL;
+}
+
+/* Sets an int sysctl of the netns within its bounds; -1 if there is none */
+static inline int sim_sysctl(const char *name, int value)
+{
+	const struct ctl_table *t;
+	size_t i, j;
+
+	for (i = 0; i < SIM_NET_IDS; i++) {
+		for (j = 0; j < sim_sysctl_tables[i].size; j++) {
+			t = &sim_sysctl_tables[i].ctl_table_arg[j];
+			if (!t->procname || strcmp(t->procname, name))
+				continue;
+			if ((t->extra1 && value < *(const int *)t->extra1) ||
+			    (t->extra2 && value > *(const int *)t->extra2))
+				return -1;
+			*(int *)t->data = value;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static inline void sim_pernet_reset(void)
+{
+	while (sim_net_ids)
+		free(sim_net_storage[--sim_net_ids]);
+	memset(sim_sysctl_tables, 0, sizeof(sim_sysctl_tables));
+}
+
+/* linux/slab.h */
+#define GFP_KERNEL	0
+#define GFP_ATOMIC	0
+#define kmalloc(size, gfp)	malloc(size)
+static inline void *kmemdup(const void *src, size_t len, int gfp)
+{
+	void *p = malloc(len);
+
+	return p ? memcpy(p, src, len) : NULL;
+}
+#define kfree(p)	free(p)
+
+/* linux/btf.h, linux/btf_ids.h (check_set and the BTF_SET of 5.19) */
+struct btf_id_set { u32 cnt; };
+struct btf_id_set8 { u32 cnt; };
+struct btf_kfunc_id_set {
+	void			*owner;
+	struct btf_id_set	*check_set;
+	struct btf_id_set8	*set;
+};
+#define BTF_SET_START(name)	static struct btf_id_set name;
+#define BTF_SET_END(name)
+#define BTF_ID(prefix, name)
+#define BTF_SET8_START(name)	static struct btf_id_set8 name;
+#define BTF_SET8_END(name)
+#define BTF_ID_FLAGS(prefix, name)
+#define BPF_PROG_TYPE_STRUCT_OPS	0
+static inline int register_btf_kfunc_id_set(int type, const struct btf_kfunc_id_set *s) { return 0; }
+
+/* Statistics are not kept */
+#define NET_INC_STATS(net, field)		do { } while (0)
+#define NET_ADD_STATS(net, field, adnd)		do { } while (0)
+
+/* include/linux/win_minmax.h, lib/win_minmax.c */
+struct minmax_sample {
+	u32	t;
+	u32	v;
+};
+
+struct minmax {
+	struct minmax_sample s[3];
+};
+
+static inline u32 minmax_get(const struct minmax *m)
+{
+	return m->s[0].v;
+}
+
+static inline u32 minmax_reset(struct minmax *m, u32 t, u32 meas)
+{
+	struct minmax_sample val = { .t = t, .v = meas };
+
+	m->s[2] = m->s[1] = m->s[0] = val;
+	return m->s[0].v;
+}
+
+static u32 minmax_subwin_update(struct minmax *m, u32 win,
+				const struct minmax_sample *val)
+{
+	u32 dt = val->t - m->s[0].t;
+
+	if (unlikely(dt > win)) {
+		m->s[0] = m->s[1];
+		m->s[1] = m->s[2];
+		m->s[2] = *val;
+		if (unlikely(val->t - m->s[0].t > win)) {
+			m->s[0] = m->s[1];
+			m->s[1] = m->s[2];
+			m->s[2] = *val;
+		}
+	} else if (unlikely(m->s[1].t == m->s[0].t) && dt > win/4) {
+		m->s[2] = m->s[1] = *val;
+	} else if (unlikely(m->s[2].t == m->s[1].t) && dt > win/2) {
+		m->s[2] = *val;
+	}
+	return m->s[0].v;
+}
+
+static u32 minmax_running_min(struct minmax *m, u32 win, u32 t, u32 meas)
+{
+	struct minmax_sample val = { .t = t, .v = meas };
+
+	if (unlikely(val.v <= m->s[0].v) ||
+	    unlikely(val.t - m->s[2].t > win))
+		return minmax_reset(m, t, meas);
+
+	if (unlikely(val.v <= m->s[1].v))
+		m->s[2] = m->s[1] = val;
+	else if (unlikely(val.v <= m->s[2].v))
+		m->s[2] = val;
+
+	return minmax_subwin_update(m, win, &val);
+}
+
+/* Sockets: one linear skb per segment, IPv4 */
+#define AF_INET		2
+#define AF_INET6	10
+
+/* net/inetpeer.h: IPv4 only, as struct sock */
+struct inetpeer_addr {
+	u32	a4;
+	u16	family;
+};
+static inline void inetpeer_set_addr_v4(struct inetpeer_addr *iaddr, u32 ip)
+{
+	iaddr->a4 = ip;
+	iaddr->family = AF_INET;
+}
+static inline int inetpeer_addr_cmp(const struct inetpeer_addr *a, const struct inetpeer_addr *b)
+{
+	if (a->family != b->family)
+		return a->family < b->family ? -1 : 1;
+	return a->a4 == b->a4 ? 0 : (a->a4 < b->a4 ? -1 : 1);
+}
+
+#define TCPHDR_FIN	0x01
+#define TCPHDR_CWR	0x80
+
+enum sk_pacing {
+	SK_PACING_NONE		= 0,
+	SK_PACING_NEEDED	= 1,
+	SK_PACING_FQ		= 2,
+};
+
+struct tcp_skb_cb {
+	u32	seq;
+	u32	end_seq;
+	u8	tcp_flags;
+};
+
+struct sk_buff {
+	struct tcp_skb_cb	cb;
+	unsigned int		len;
+	u64			skb_mstamp_ns;
+};
+#define TCP_SKB_CB(__skb)	(&(__skb)->cb)
+static inline int tcp_skb_pcount(const struct sk_buff *skb) { return 1; }
+
+struct sock {
+	u16		sk_family;
+	u32		sk_daddr;
+	u32		sk_pacing_status;	/* see enum sk_pacing */
+	unsigned long	sk_pacing_rate;		/* bytes per second */
+	unsigned long	sk_max_pacing_rate;
+	unsigned int	sk_gso_max_size;
+	struct sk_buff	*sk_write_tail;		/* the tail of sk_write_queue */
+};
+
+struct inet_sock {
+	struct sock	sk;
+	u16		inet_sport;		/* as the kernel prints it (__be16) */
+	u16		inet_dport;
+};
+
+#define ICSK_CA_PRIV_SIZE	(13 * sizeof(u64))
+
+struct inet_connection_sock {
+	struct inet_sock			icsk_inet;
+	const struct tcp_congestion_ops		*icsk_ca_ops;
+	u8					icsk_ca_state;
+	u8					icsk_retransmits;
+	u8					icsk_backoff;
+	u32					icsk_rto;	/* us */
+	u64					icsk_ca_priv[ICSK_CA_PRIV_SIZE / sizeof(u64)];
+};
+
+struct tcp_sock {
+	struct inet_connection_sock	inet_conn;
+	u32	snd_una;
+	u32	snd_nxt;
+	u32	write_seq;
+	u32	snd_wnd;
+	u32	mss_cache;
+	u32	snd_cwnd;
+	u32	snd_ssthresh;
+	u32	snd_cwnd_cnt;
+	u32	snd_cwnd_clamp;
+	u32	snd_cwnd_stamp;
+	u32	snd_cwnd_used;
+	u32	prior_cwnd;
+	u32	prior_ssthresh;
+	u32	prr_delivered;
+	u32	prr_out;
+	u32	packets_out;
+	u32	sacked_out;
+	u32	lost_out;
+	u32	retrans_out;
+	u32	max_packets_out;
+	u32	cwnd_usage_seq;
+	u8	is_cwnd_limited;
+	u8	ecn_flags;
+	u32	high_seq;
+	u32	undo_marker;
+	u32	delivered;
+	u32	lost;
+	u32	total_retrans;
+	u32	data_segs_out;
+	u32	srtt_us;
+	u32	mdev_us;
+	u32	mdev_max_us;
+	u32	rttvar_us;
+	u32	rtt_seq;
+	u32	lsndtime;
+	u64	tcp_mstamp;
+	u64	tcp_clock_cache;
+	u64	tcp_wstamp_ns;
+#include "suss_fields.h"
+};
+
+static inline struct tcp_sock *tcp_sk(const struct sock *sk) { return (struct tcp_sock *)sk; }
+static inline struct inet_sock *inet_sk(const struct sock *sk) { return (struct inet_sock *)sk; }
+static inline struct inet_connection_sock *inet_csk(const struct sock *sk) { return (struct inet_connection_sock *)sk; }
+static inline void *inet_csk_ca(const struct sock *sk) { return inet_csk(sk)->icsk_ca_priv; }
+static inline struct net *sock_net(const struct sock *sk) { return &init_net; }
+static inline struct sk_buff *tcp_write_queue_tail(const struct sock *sk) { return sk->sk_write_tail; }
+
+static inline bool before(u32 seq1, u32 seq2) { return (s32)(seq1 - seq2) < 0; }
+#define after(seq2, seq1)	before(seq1, seq2)
+
+/* net/tcp.h: congestion control */
+#define TCP_INIT_CWND		10
+#define TCP_INFINITE_SSTHRESH	0x7fffffff
+#define TCP_RTO_MIN_US		200000U
+#define TCP_RTO_MAX_US		120000000U
+#define TCP_ECN_OK		1
+#define TCP_ECN_QUEUE_CWR	2
+
+enum tcp_ca_state {
+	TCP_CA_Open = 0,
+	TCP_CA_Disorder = 1,
+	TCP_CA_CWR = 2,
+	TCP_CA_Recovery = 3,
+	TCP_CA_Loss = 4
+};
+
+enum tcp_ca_event {
+	CA_EVENT_TX_START,
+	CA_EVENT_CWND_RESTART,
+	CA_EVENT_COMPLETE_CWR,
+	CA_EVENT_LOSS,
+	CA_EVENT_ECN_NO_CE,
+	CA_EVENT_ECN_IS_CE,
+};
+
+enum tcp_ca_ack_event_flags {
+	CA_ACK_SLOWPATH		= (1 << 0),
+	CA_ACK_WIN_UPDATE	= (1 << 1),
+	CA_ACK_ECE		= (1 << 2),
+};
+
+struct ack_sample {
+	u32 pkts_acked;
+	s32 rtt_us;
+	u32 in_flight;
+};
+
+struct tcp_congestion_ops {
+	u32 (*ssthresh)(struct sock *sk);
+	void (*cong_avoid)(struct sock *sk, u32 ack, u32 acked);
+	void (*set_state)(struct sock *sk, u8 new_state);
+	void (*cwnd_event)(struct sock *sk, enum tcp_ca_event ev);
+	void (*in_ack_event)(struct sock *sk, u32 flags);
+	void (*pkts_acked)(struct sock *sk, const struct ack_sample *sample);
+	u32 (*undo_cwnd)(struct sock *sk);
+	void (*init)(struct sock *sk);
+	void (*release)(struct sock *sk);
+	u32 flags;
+	char name[16];
+	void *owner;
+};
+
+static inline u32 tcp_snd_cwnd(const struct tcp_sock *tp) { return tp->snd_cwnd; }
+static inline void tcp_snd_cwnd_set(struct tcp_sock *tp, u32 val) { tp->snd_cwnd = val; }
+static inline bool tcp_in_slow_start(const struct tcp_sock *tp) { return tcp_snd_cwnd(tp) < tp->snd_ssthresh; }
+
+static inline unsigned int tcp_packets_in_flight(const struct tcp_sock *tp)
+{
+	return tp->packets_out - (tp->sacked_out + tp->lost_out) + tp->retrans_out;
+}
+
+static inline bool tcp_is_cwnd_limited(const struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+
+	if (tp->is_cwnd_limited)
+		return true;
+
+	/* If in slow start, ensure cwnd grows to twice what was ACKed. */
+	if (tcp_in_slow_start(tp))
+		return tcp_snd_cwnd(tp) < 2 * tp->max_packets_out;
+
+	return false;
+}
+
+/* net/ipv4/tcp_cong.c */
+static u32 tcp_slow_start(struct tcp_sock *tp, u32 acked)
+{
+	u32 cwnd = min(tcp_snd_cwnd(tp) + acked, tp->snd_ssthresh);
+
+	acked -= cwnd - tcp_snd_cwnd(tp);
+	tcp_snd_cwnd_set(tp, min(cwnd, tp->snd_cwnd_clamp));
+
+	return acked;
+}
+
+static void tcp_cong_avoid_ai(struct tcp_sock *tp, u32 w, u32 acked)
+{
+	/* If credits accumulated at a higher w, apply them gently now. */
+	if (tp->snd_cwnd_cnt >= w) {
+		tp->snd_cwnd_cnt = 0;
+		tcp_snd_cwnd_set(tp, tcp_snd_cwnd(tp) + 1);
+	}
+
+	tp->snd_cwnd_cnt += acked;
+	if (tp->snd_cwnd_cnt >= w) {
+		u32 delta = tp->snd_cwnd_cnt / w;
+
+		tp->snd_cwnd_cnt -= delta * w;
+		tcp_snd_cwnd_set(tp, tcp_snd_cwnd(tp) + delta);
+	}
+	tcp_snd_cwnd_set(tp, min(tcp_snd_cwnd(tp), tp->snd_cwnd_clamp));
+}
+
+static u32 tcp_reno_undo_cwnd(struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+
+	return max(tcp_snd_cwnd(tp), tp->prior_cwnd);
+}
+
+/* The congestion controls that are registered (see sim_ca_find) */
+#define SIM_CA_MAX	4
+static struct tcp_congestion_ops *sim_ca_list[SIM_CA_MAX];
+
+static int tcp_register_congestion_control(struct tcp_congestion_ops *ca)
+{
+	int i;
+
+	for (i = 0; i < SIM_CA_MAX; i++) {
+		if (!sim_ca_list[i] || sim_ca_list[i] == ca) {
+			sim_ca_list[i] = ca;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static void tcp_unregister_congestion_control(struct tcp_congestion_ops *ca)
+{
+	int i;
+
+	for (i = 0; i < SIM_CA_MAX; i++)
+		if (sim_ca_list[i] == ca)
+			sim_ca_list[i] = NULL;
+}
+
+#endif /* SIM_SHIM_KERNEL_H */
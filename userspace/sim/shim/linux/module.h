@@ -0,0 +1 @@
+#include "../kernel.h"
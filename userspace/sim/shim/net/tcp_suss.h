@@ -0,0 +1 @@
+#include "../../../../sourceCode/linux-6.8/suss/tcp_suss.h"
@@ -0,0 +1,492 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Discrete-event simulator of SUSS downloads.
+ *
+ * The senders are the TCP of sim_kernel.c, i.e., the congestion control and
+ * SUSS of the kernel source tree; this file is the rest: the NIC of the
+ * server, the bottleneck link, the propagation delay, the receivers (delayed
+ * ACK, quick ACK, SACK, ECN echo) and the clock.
+ *
+ *	sim::scenario sc;		// 100 Mbit/s, 50 ms, 1 BDP of buffer, ...
+ *	sc.params = { { "suss", 1 } };
+ *	for (const sim::flow_result &r : sim::run(sc))
+ *		... r.fct_us, r.ss_exit_us, r.jumps
+ *
+ * All flows go from one server to one client over the same bottleneck. A run
+ * uses the module state of its kernel (the statics of tcp_suss.c and
+ * tcp_cubic.c), so only one run at a time may use a given kernel.
+ */
+#ifndef SIM_HPP
+#define SIM_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sim_kernel.h"
+
+namespace sim {
+
+using u8 = std::uint8_t;
+using u16 = std::uint16_t;
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+
+constexpr u32 HEADER_BYTES = 52;	/* IPv4 and TCP with timestamps */
+constexpr u64 NSEC_PER_USEC = 1000;
+constexpr u64 NSEC_PER_MSEC = 1000000;
+constexpr u64 NSEC_PER_SEC = 1000000000;
+
+/* The bottleneck. enqueue() is called in the order of the arrival times. */
+class link {
+public:
+	virtual ~link() = default;
+	/* A packet of `bytes` arrives at `now_ns`. Returns false if it is
+	 * dropped; else `depart_ns` is the time at which its last bit leaves,
+	 * and `ce` tells if it is CE marked. */
+	virtual bool enqueue(u64 now_ns, u32 bytes, u64 &depart_ns, bool &ce) = 0;
+};
+
+/* A FIFO served at a fixed rate, drop tail. Its backlog follows from the time
+ * at which it is next free, so a packet costs O(1). */
+class fifo_link : public link {
+public:
+	fifo_link(double rate_bps, u64 buffer_bytes, double loss, u64 ecn_bytes, u64 seed)
+		: ns_per_byte_(8e9 / rate_bps), buffer_(buffer_bytes), ecn_(ecn_bytes),
+		  loss_(loss), rng_(seed)
+	{
+	}
+
+	bool enqueue(u64 now_ns, u32 bytes, u64 &depart_ns, bool &ce) override
+	{
+		double now = (double)now_ns;
+		double backlog = free_at_ > now ? (free_at_ - now) / ns_per_byte_ : 0;
+
+		if (backlog + bytes > (double)buffer_ + 0.5)
+			return false;
+		if (loss_ > 0 && std::uniform_real_distribution<double>(0, 1)(rng_) < loss_)
+			return false;
+		ce = ecn_ && backlog >= (double)ecn_;
+		free_at_ = std::max(free_at_, now) + bytes * ns_per_byte_;
+		depart_ns = (u64)free_at_;
+		return true;
+	}
+
+private:
+	double ns_per_byte_;
+	u64 buffer_;
+	u64 ecn_;		/* CE threshold of the backlog, 0 if no ECN */
+	double loss_;		/* random loss, before the queue */
+	std::mt19937_64 rng_;
+	double free_at_ = 0;
+};
+
+struct scenario {
+	const sim_kernel *kernel = &sim_kernel_6_8;
+	std::vector<std::pair<std::string, int>> params;	/* module parameters */
+
+	/* Network */
+	double rate_mbps = 100;		/* bottleneck */
+	double rtt_ms = 50;		/* base RTT */
+	double buffer_bdp = 1;		/* buffer of the bottleneck in BDPs ... */
+	u64 buffer_bytes = 0;		/* ... or in bytes, if not 0 */
+	double loss = 0;		/* random loss at the bottleneck */
+	double ecn_bdp = 0;		/* CE threshold in BDPs, 0 if no ECN */
+	double nic_mbps = 10000;	/* NIC of the server */
+	/* Makes the bottleneck, instead of a fifo_link */
+	std::function<std::unique_ptr<link>(const scenario &)> make_link;
+	/* Makes a link for the ACKs; without it they only see the delay */
+	std::function<std::unique_ptr<link>(const scenario &)> make_ack_link;
+
+	/* Flows */
+	u32 flows = 1;
+	double gap_ms = 0;		/* between the starts of the flows */
+	u64 bytes = 16 << 20;		/* size of each flow */
+	std::string cc = "cubic";
+	u32 mss = 1448;
+	u32 rwnd = 64 << 20;
+	int size_hint = SIM_HINT_NONE;
+
+	/* Receiver */
+	u32 quickack = 16;		/* segments that are acked at once at the start */
+	double delack_ms = 40;
+
+	u64 seed = 1;
+	double time_s = 600;		/* the run stops here */
+
+	u64 bdp_bytes() const { return (u64)(rate_mbps * 1e6 / 8 * rtt_ms / 1e3); }
+	/* Buffer of the bottleneck in bytes, at least one packet */
+	u64 buffer() const
+	{
+		return buffer_bytes ? buffer_bytes :
+		       std::max<u64>((u64)(buffer_bdp * bdp_bytes()), mss + HEADER_BYTES);
+	}
+};
+
+struct flow_result {
+	u32 flow;
+	u32 id;			/* as in the SUSSmsg lines */
+	u64 bytes;
+	bool done;		/* all data arrived before scenario::time_s */
+	u64 fct_us;		/* from the start of the flow to the arrival of its last byte */
+	u64 ss_exit_us;		/* end of slow start (cwnd >= ssthresh or a loss), 0 if none */
+	u32 ss_cwnd;		/* cwnd at the end of slow start */
+	u32 jumps;		/* SUSS pacing periods */
+	u32 retrans;
+	u32 lost;
+};
+
+/* Gets each printk of the kernel code: flow, time and message */
+using log_fn = std::function<void(u32 flow, u64 now_ns, const char *msg)>;
+
+class engine {
+public:
+	explicit engine(const scenario &sc, log_fn log = {})
+		: sc_(sc), log_(std::move(log)), k_(sc.kernel)
+	{
+		if (sc.make_link)
+			link_ = sc.make_link(sc);
+		else
+			link_ = std::make_unique<fifo_link>(sc.rate_mbps * 1e6, sc.buffer(), sc.loss,
+							    (u64)(sc.ecn_bdp * sc.bdp_bytes()), sc.seed);
+		if (sc.make_ack_link)
+			ack_link_ = sc.make_ack_link(sc);
+		prop_ns_ = (u64)(sc.rtt_ms * NSEC_PER_MSEC / 2);
+		nic_ns_per_byte_ = 8e3 / sc.nic_mbps;
+		flows_.resize(sc.flows);
+	}
+
+	std::vector<flow_result> run()
+	{
+		u64 end = START_NS + (u64)(sc_.time_s * NSEC_PER_SEC);
+		u32 left = sc_.flows;
+
+		for (const auto &p : sc_.params) {
+			int v = p.second;
+			k_->param(p.first.c_str(), &v, 1);
+		}
+		k_->load();
+		k_->log(&engine::on_printk, this);
+
+		for (u32 i = 0; i < sc_.flows; i++)
+			push(START_NS + (u64)(i * sc_.gap_ms * NSEC_PER_MSEC), EV_START, i);
+
+		while (left && !events_.empty() && events_.top().t <= end) {
+			event ev = events_.top();
+
+			events_.pop();
+			now_ = ev.t;
+			cur_ = ev.flow;
+			if (handle(ev))
+				left--;
+		}
+		k_->log(nullptr, nullptr);
+
+		std::vector<flow_result> res;
+		for (u32 i = 0; i < sc_.flows; i++) {
+			flow &f = flows_[i];
+
+			if (f.s)
+				finish(f);
+			f.res.flow = i;
+			res.push_back(f.res);
+		}
+		return res;
+	}
+
+private:
+	static constexpr u64 START_NS = NSEC_PER_SEC;
+
+	enum : u8 { EV_START, EV_SEND, EV_RTO, EV_DATA, EV_ACK, EV_DELACK };
+	enum : u8 { SEG_CE = 1, SEG_CWR = 2 };
+
+	struct event {
+		u64 t;
+		u64 seq;
+		u8 type;
+		u8 flags;
+		u32 flow;
+		u32 a;		/* EV_DATA: segment; EV_ACK: cum */
+		u32 b;		/* EV_ACK: sack */
+
+		bool operator>(const event &o) const
+		{
+			return t != o.t ? t > o.t : seq > o.seq;
+		}
+	};
+
+	struct flow {
+		sim_sock *s = nullptr;
+		u64 start_ns = 0;
+		u32 segs = 0;
+		u64 pace_at = 0;	/* pending EV_SEND */
+		u64 rto_at = 0;		/* pending EV_RTO */
+		bool ss_done = false;
+
+		/* Receiver */
+		std::vector<u8> rcvd;
+		u32 cum = 0;
+		u32 ooo = 0;		/* segments received above cum */
+		u32 pending = 0;	/* segments not acked yet */
+		u32 quick = 0;
+		bool ece = false;
+		u64 delack_at = 0;
+		u64 last_ns = 0;	/* arrival of the last byte */
+
+		flow_result res = {};
+	};
+
+	void push(u64 t, u8 type, u32 fl, u32 a = 0, u32 b = 0, u8 flags = 0)
+	{
+		events_.push({ t, seq_++, type, flags, fl, a, b });
+	}
+
+	static void on_printk(void *ctx, const char *msg)
+	{
+		engine *e = static_cast<engine *>(ctx);
+
+		if (e->log_)
+			e->log_(e->cur_, e->now_, msg);
+	}
+
+	static void on_emit(void *ctx, const sim_seg *seg)
+	{
+		static_cast<engine *>(ctx)->emit(*seg);
+	}
+
+	/* A segment leaves the sender: the NIC, then the bottleneck */
+	void emit(const sim_seg &seg)
+	{
+		u32 wire = seg.len + HEADER_BYTES;
+		u64 depart;
+		bool ce = false;
+
+		nic_free_ = std::max(nic_free_, (double)std::max(now_, seg.time_ns)) +
+			    wire * nic_ns_per_byte_;
+		if (!link_->enqueue((u64)nic_free_, wire, depart, ce))
+			return;
+		push(depart + prop_ns_, EV_DATA, cur_, seg.idx, 0,
+		     (ce ? SEG_CE : 0) | (seg.cwr ? SEG_CWR : 0));
+	}
+
+	void xmit(flow &f)
+	{
+		u64 next = k_->write_xmit(f.s, now_, &engine::on_emit, this);
+
+		if (next && next != f.pace_at) {
+			f.pace_at = next;
+			push(next, EV_SEND, cur_);
+		}
+		arm_rto(f);
+	}
+
+	void arm_rto(flow &f)
+	{
+		u64 t = k_->rto_time(f.s);
+
+		if (t && (!f.rto_at || t < f.rto_at)) {
+			f.rto_at = t;
+			push(t, EV_RTO, cur_);
+		}
+	}
+
+	void check_slow_start(flow &f)
+	{
+		sim_info info;
+
+		if (f.ss_done)
+			return;
+		k_->info(f.s, &info);
+		if (info.slow_start && !info.ca_state)
+			return;
+		f.ss_done = true;
+		f.res.ss_exit_us = (now_ - f.start_ns) / NSEC_PER_USEC;
+		f.res.ss_cwnd = info.cwnd;
+	}
+
+	void finish(flow &f)
+	{
+		sim_info info;
+
+		k_->info(f.s, &info);
+		f.res.jumps = info.suss_jumps;
+		f.res.retrans = info.retrans;
+		f.res.lost = info.lost;
+		k_->close(f.s);
+		f.s = nullptr;
+	}
+
+	void send_ack(flow &f, u32 sack)
+	{
+		u64 t = now_;
+		bool ce;
+
+		f.pending = 0;
+		f.delack_at = 0;
+		if (ack_link_ && !ack_link_->enqueue(now_, HEADER_BYTES, t, ce))
+			return;
+		push(t + prop_ns_, EV_ACK, cur_, f.cum, sack, f.ece);
+	}
+
+	void receive(flow &f, u32 idx, u8 flags)
+	{
+		bool now = false;
+		u32 sack = UINT32_MAX;
+
+		if (flags & SEG_CWR)
+			f.ece = false;
+		if (flags & SEG_CE) {
+			f.ece = true;
+			now = true;
+		}
+
+		if (idx < f.cum || f.rcvd[idx]) {
+			now = true;		/* duplicate */
+		} else if (idx > f.cum) {
+			f.rcvd[idx] = 1;	/* out of order */
+			f.ooo++;
+			sack = idx;
+			now = true;
+		} else {
+			bool hole = f.ooo;
+
+			f.rcvd[idx] = 1;
+			for (f.cum++; f.cum < f.segs && f.rcvd[f.cum]; f.cum++)
+				f.ooo--;
+			f.pending++;
+			if (hole || f.pending >= 2)
+				now = true;
+			if (f.quick) {
+				f.quick--;
+				now = true;
+			}
+			if (f.cum == f.segs) {
+				f.last_ns = now_;
+				now = true;
+			}
+		}
+
+		if (now) {
+			send_ack(f, sack);
+		} else if (!f.delack_at) {
+			f.delack_at = now_ + (u64)(sc_.delack_ms * NSEC_PER_MSEC);
+			push(f.delack_at, EV_DELACK, cur_);
+		}
+	}
+
+	/* Returns true when the flow is done */
+	bool handle(const event &ev)
+	{
+		flow &f = flows_[ev.flow];
+
+		switch (ev.type) {
+		case EV_START: {
+			sim_conn conn = {};
+			sim_info info;
+
+			conn.cc = sc_.cc.c_str();
+			conn.mss = sc_.mss;
+			conn.bytes = (u32)sc_.bytes;
+			conn.rwnd = sc_.rwnd;
+			conn.syn_rtt_us = (u32)(sc_.rtt_ms * 1000);
+			conn.daddr = 0x0a000002;
+			conn.sport = 20480;
+			conn.dport = (u16)(40000 + ev.flow);
+			conn.size_hint = sc_.size_hint;
+			conn.ecn = sc_.ecn_bdp > 0;
+			f.s = k_->connect(&conn, now_);
+			if (!f.s)
+				return true;
+			k_->info(f.s, &info);
+			f.res.id = info.id;
+			f.res.bytes = sc_.bytes;
+			f.start_ns = now_;
+			f.segs = (u32)((sc_.bytes + sc_.mss - 1) / sc_.mss);
+			f.rcvd.assign(f.segs, 0);
+			f.quick = sc_.quickack;
+			xmit(f);
+			return false;
+		}
+		case EV_SEND:
+			if (!f.s || ev.t != f.pace_at)
+				return false;
+			f.pace_at = 0;
+			xmit(f);
+			return false;
+		case EV_RTO: {
+			u64 t;
+
+			if (!f.s || ev.t != f.rto_at)
+				return false;
+			f.rto_at = 0;
+			t = k_->rto_time(f.s);
+			if (t > now_) {
+				arm_rto(f);
+				return false;
+			}
+			if (t) {
+				k_->rto(f.s, now_);
+				check_slow_start(f);
+			}
+			xmit(f);
+			return false;
+		}
+		case EV_DATA:
+			receive(f, ev.a, ev.flags);
+			return false;
+		case EV_DELACK:
+			if (ev.t == f.delack_at && f.pending)
+				send_ack(f, UINT32_MAX);
+			return false;
+		case EV_ACK: {
+			sim_ack ack = { ev.a, ev.b, ev.flags };
+			sim_info info;
+
+			if (!f.s)
+				return false;
+			k_->ack(f.s, now_, &ack);
+			check_slow_start(f);
+			k_->info(f.s, &info);
+			if (info.acked >= f.segs) {
+				f.res.done = true;
+				f.res.fct_us = (f.last_ns - f.start_ns) / NSEC_PER_USEC;
+				finish(f);
+				return true;
+			}
+			xmit(f);
+			return false;
+		}
+		}
+		return false;
+	}
+
+	const scenario &sc_;
+	log_fn log_;
+	const sim_kernel *k_;
+	std::unique_ptr<link> link_;
+	std::unique_ptr<link> ack_link_;	/* may be null */
+	u64 prop_ns_;
+	double nic_ns_per_byte_;
+	double nic_free_ = 0;
+
+	std::vector<flow> flows_;
+	std::priority_queue<event, std::vector<event>, std::greater<event>> events_;
+	u64 seq_ = 0;
+	u64 now_ = 0;
+	u32 cur_ = 0;		/* flow of the event being handled */
+};
+
+inline std::vector<flow_result> run(const scenario &sc, log_fn log = {})
+{
+	return engine(sc, std::move(log)).run();
+}
+
+} /* namespace sim */
+
+#endif /* SIM_HPP */
@@ -0,0 +1,1136 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * tcp_suss.c and tcp_cubic.c of sourceCode/linux-6.8/suss, unchanged and
+ * compiled in user space against shim/, with a TCP sender that calls them
+ * where the TCP core does and in the same order:
+ *
+ *	tcp_init_congestion_control	blocks B2, B3 of tcp_cong.c
+ *	tcp_update_skb_after_send	blocks D4, D1 of tcp_output.c
+ *	tcp_update_pacing_rate		line C1 of tcp_input.c
+ *	tcp_enter_loss			blocks C2, C6
+ *	tcp_init_cwnd_reduction		block C3
+ *	tcp_clean_rtx_queue		line C4
+ *	tcp_in_ack_event		line C5
+ *
+ * With -DSIM_LINUX_5_19 (and -I of sourceCode/linux-5.19.10/suss), it is
+ * tcp_cubic.c of that tree instead, which has SUSS inside, and the sender
+ * runs the suss blocks of its tcp_input.c and tcp_output.c instead of the
+ * ones of 6.8; the build is sim_kernel_5_19. The blocks of 5.19 that change
+ * the receiver window and the TSQ check do nothing here, as the simulator has
+ * neither.
+ *
+ * The sender is the part of tcp_input.c, tcp_output.c and tcp_timer.c that
+ * matters for a bulk flow: SACK with RACK loss marking, PRR in CWR and
+ * recovery, RTO with backoff, ECN, EDT pacing (internal, as without fq) and
+ * the cwnd validation. It has no TLP, undo, TSO, TSQ or restart after idle,
+ * and the receiver window does not change.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef SIM_SLOT
+#include "sim_slot.h"
+#endif
+#ifdef SIM_LINUX_5_19
+#include "tcp_cubic.c"
+#else
+#include "tcp_suss.c"
+#include "tcp_cubic.c"
+#endif
+#include "sim_kernel.h"
+
+#ifdef SIM_LINUX_5_19
+/* SUSS is part of CUBIC, and the TCP core has no hooks for it */
+static inline void tcp_suss_init(struct sock *sk) { }
+static inline void tcp_suss_cong_avoid(struct sock *sk, u32 ack, u32 acked) { }
+static inline void tcp_suss_release(struct sock *sk) { }
+static inline void tcp_suss_acked(struct sock *sk, s32 rtt_us) { }
+static inline void tcp_suss_in_ack_event(struct sock *sk, u32 flags) { }
+static inline void tcp_suss_cwnd_reduction(struct sock *sk) { }
+static inline void tcp_suss_enter_loss(struct sock *sk) { }
+#define SIM_KERNEL		sim_kernel_5_19
+#define SIM_TREE		"linux-5.19.10"
+#else
+#define SIM_KERNEL		sim_kernel_6_8
+#define SIM_TREE		"linux-6.8"
+#endif
+
+#define SIM_ISN			0U
+#define TCP_TIMEOUT_INIT_US	1000000U
+
+/* Flags of tcp_ack() */
+#define FLAG_DATA_ACKED		0x04
+#define FLAG_RETRANS_DATA_ACKED	0x08
+#define FLAG_DATA_SACKED	0x20
+#define FLAG_ECE		0x40
+#define FLAG_SLOWPATH		0x100
+#define FLAG_SND_UNA_ADVANCED	0x400
+
+/* State of a segment (TCP_SKB_CB(skb)->sacked) */
+#define SIM_SACKED		0x01	/* TCPCB_SACKED_ACKED	*/
+#define SIM_RETRANS		0x02	/* TCPCB_SACKED_RETRANS	*/
+#define SIM_LOST		0x04	/* TCPCB_LOST		*/
+#define SIM_EVER_RETRANS	0x08	/* TCPCB_EVER_RETRANS	*/
+
+struct sim_sock {
+	struct tcp_sock	tp;
+	struct sk_buff	fin;		/* tail of the write queue with SIM_HINT_FIN	*/
+	u32		bytes;
+	u32		segs;		/* segments of the flow				*/
+	u32		una;		/* first segment that is not acked in order	*/
+	u32		nxt;		/* next new segment				*/
+	u32		rtx_hint;	/* no segment before it is to be retransmitted	*/
+	u32		nxt_max;	/* no new segment from it on (sim_ack), or 0	*/
+	u8		*state;
+	u64		*xmit_ns;	/* last departure of each segment		*/
+	u64		rack_ns;	/* last departure of a delivered segment	*/
+	u32		rack_rtt_us;	/* RTT of that segment				*/
+	u64		rto_ns;		/* retransmission timer, 0 if not armed		*/
+	struct sim_suss_input in;	/* what SUSS is given on the ACK	*/
+};
+
+static void (*sim_log_fn)(void *ctx, const char *msg);
+static void *sim_log_ctx;
+static void (*sim_input_fn)(void *ctx, const struct sim_sock *s, const struct sim_suss_input *in);
+static void *sim_input_ctx;
+
+static void sim_printk(const char *fmt, ...)
+{
+	char msg[512];
+	va_list ap;
+
+	if (!sim_log_fn)
+		return;
+	va_start(ap, fmt);
+	vsnprintf(msg, sizeof(msg), fmt, ap);
+	va_end(ap);
+	sim_log_fn(sim_log_ctx, msg);
+}
+
+static inline struct sock *sim_sk(struct sim_sock *s)
+{
+	return (struct sock *)&s->tp;
+}
+
+static void sim_clock(struct sim_sock *s, u64 now_ns)
+{
+	s->tp.tcp_clock_cache = now_ns;
+	s->tp.tcp_mstamp = div_u64(now_ns, NSEC_PER_USEC);
+	jiffies = div_u64(now_ns, NSEC_PER_SEC / HZ);
+	tcp_jiffies32 = (u32)jiffies;
+}
+
+static u32 sim_seq(const struct sim_sock *s, u32 idx)
+{
+	return SIM_ISN + (u32)min_t(u64, (u64)idx * s->tp.mss_cache, s->bytes);
+}
+
+/* Hands s->in to the receiver of sim_kernel::suss_input, with what holds
+ * after the event */
+static void sim_suss_input(struct sim_sock *s, int event)
+{
+	struct tcp_sock *tp = &s->tp;
+
+	if (!sim_input_fn)
+		return;
+	s->in.event = event;
+	s->in.now_ns = tp->tcp_clock_cache;
+	s->in.snd_una = tp->snd_una;
+	s->in.snd_nxt = tp->snd_nxt;
+	s->in.srtt_us = tp->srtt_us >> 3;
+	s->in.snd_wnd = tp->snd_wnd;
+#ifndef SIM_LINUX_5_19
+	s->in.left = suss_pkts_left(sim_sk(s));
+#endif
+	sim_input_fn(sim_input_ctx, s, &s->in);
+}
+
+/* net/ipv4/tcp_cong.c: Reno */
+static void tcp_reno_cong_avoid(struct sock *sk, u32 ack, u32 acked)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+
+	tcp_suss_cong_avoid(sk, ack, acked);	/* as line B3 */
+
+	((struct sim_sock *)sk)->in.cwnd_limited = tcp_is_cwnd_limited(sk);
+	if (!tcp_is_cwnd_limited(sk))
+		return;
+
+	/* In "safe" area, increase. */
+	if (tcp_in_slow_start(tp)) {
+		acked = tcp_slow_start(tp, acked);
+		if (!acked)
+			return;
+	}
+	/* In dangerous area, increase slowly. */
+	tcp_cong_avoid_ai(tp, tcp_snd_cwnd(tp), acked);
+}
+
+static u32 tcp_reno_ssthresh(struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+
+	return max(tcp_snd_cwnd(tp) >> 1U, 2U);
+}
+
+static struct tcp_congestion_ops tcp_reno = {
+	.name		= "reno",
+	.ssthresh	= tcp_reno_ssthresh,
+	.cong_avoid	= tcp_reno_cong_avoid,
+	.undo_cwnd	= tcp_reno_undo_cwnd,
+};
+
+static const struct tcp_congestion_ops *sim_ca_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < SIM_CA_MAX; i++)
+		if (sim_ca_list[i] && !strcmp(sim_ca_list[i]->name, name))
+			return sim_ca_list[i];
+	return NULL;
+}
+
+static void tcp_init_congestion_control(struct sock *sk)
+{
+	struct inet_connection_sock *icsk = inet_csk(sk);
+
+	/* as block B2 */
+	struct tcp_sock *tp = tcp_sk(sk);
+	get_random_bytes(&tp->suss_msg_id, sizeof(tp->suss_msg_id));
+	printk(KERN_INFO "SUSSmsg %s starts sending data. Follow id=%u for Sport=%u", icsk->icsk_ca_ops->name, tp->suss_msg_id, inet_sk(sk)->inet_sport);
+	tp->snd_isn = tp->snd_una;
+#ifndef SIM_LINUX_5_19
+	tp->suss_state = 10;
+	tp->suss_log = 0;
+#endif
+
+	tcp_sk(sk)->prior_ssthresh = 0;
+	if (icsk->icsk_ca_ops->init)
+		icsk->icsk_ca_ops->init(sk);
+	/* as block B3 */
+	if (icsk->icsk_ca_ops->cong_avoid == tcp_reno_cong_avoid)
+		tcp_suss_init(sk);
+}
+
+static void tcp_cleanup_congestion_control(struct sock *sk)
+{
+	struct inet_connection_sock *icsk = inet_csk(sk);
+
+	if (icsk->icsk_ca_ops->release)
+		icsk->icsk_ca_ops->release(sk);
+	tcp_suss_release(sk);	/* as line B3 */
+}
+
+static void tcp_ca_event(struct sock *sk, const enum tcp_ca_event event)
+{
+	const struct inet_connection_sock *icsk = inet_csk(sk);
+
+	if (icsk->icsk_ca_ops->cwnd_event)
+		icsk->icsk_ca_ops->cwnd_event(sk, event);
+}
+
+static void tcp_set_ca_state(struct sock *sk, const u8 ca_state)
+{
+	struct inet_connection_sock *icsk = inet_csk(sk);
+
+	if (icsk->icsk_ca_ops->set_state)
+		icsk->icsk_ca_ops->set_state(sk, ca_state);
+	icsk->icsk_ca_state = ca_state;
+}
+
+static bool tcp_in_cwnd_reduction(const struct sock *sk)
+{
+	return ((1 << inet_csk(sk)->icsk_ca_state) &
+		((1 << TCP_CA_CWR) | (1 << TCP_CA_Recovery)));
+}
+
+static void tcp_ecn_queue_cwr(struct tcp_sock *tp)
+{
+	if (tp->ecn_flags & TCP_ECN_OK)
+		tp->ecn_flags |= TCP_ECN_QUEUE_CWR;
+}
+
+/* net/ipv4/tcp_input.c: RTT and RTO */
+static void tcp_rtt_estimator(struct sock *sk, long mrtt_us)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	long m = mrtt_us; /* RTT */
+	u32 srtt = tp->srtt_us;
+
+	if (srtt != 0) {
+		m -= (srtt >> 3);	/* m is now error in rtt est */
+		srtt += m;		/* rtt = 7/8 rtt + 1/8 new */
+		if (m < 0) {
+			m = -m;		/* m is now abs(error) */
+			m -= (tp->mdev_us >> 2);   /* similar update on mdev */
+			if (m > 0)
+				m >>= 3;
+		} else {
+			m -= (tp->mdev_us >> 2);   /* similar update on mdev */
+		}
+		tp->mdev_us += m;		/* mdev = 3/4 mdev + 1/4 new */
+		if (tp->mdev_us > tp->mdev_max_us) {
+			tp->mdev_max_us = tp->mdev_us;
+			if (tp->mdev_max_us > tp->rttvar_us)
+				tp->rttvar_us = tp->mdev_max_us;
+		}
+		if (after(tp->snd_una, tp->rtt_seq)) {
+			if (tp->mdev_max_us < tp->rttvar_us)
+				tp->rttvar_us -= (tp->rttvar_us - tp->mdev_max_us) >> 2;
+			tp->rtt_seq = tp->snd_nxt;
+			tp->mdev_max_us = TCP_RTO_MIN_US;
+		}
+	} else {
+		/* no previous measure. */
+		srtt = m << 3;		/* take the measured time to be rtt */
+		tp->mdev_us = m << 1;	/* make sure rto = 3*rtt */
+		tp->rttvar_us = max(tp->mdev_us, TCP_RTO_MIN_US);
+		tp->mdev_max_us = tp->rttvar_us;
+		tp->rtt_seq = tp->snd_nxt;
+	}
+	tp->srtt_us = max(1U, srtt);
+}
+
+static void tcp_set_rto(struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+
+	inet_csk(sk)->icsk_rto = min((tp->srtt_us >> 3) + tp->rttvar_us, TCP_RTO_MAX_US);
+}
+
+static void tcp_update_pacing_rate(struct sock *sk)
+{
+	const struct tcp_sock *tp = tcp_sk(sk);
+	u64 rate;
+
+	/* set sk_pacing_rate to 200 % of current rate (mss * cwnd / srtt) */
+	rate = (u64)tp->mss_cache * ((USEC_PER_SEC / 100) << 3);
+
+	/* In Slow Start, 200 % of the current rate (tcp_pacing_ss_ratio); in
+	 * Congestion Avoidance, 120 % (tcp_pacing_ca_ratio). */
+	if (tcp_snd_cwnd(tp) < tp->snd_ssthresh / 2)
+		rate *= 200;
+	else
+		rate *= 120;
+
+	rate *= max(tcp_snd_cwnd(tp), tp->packets_out);
+
+	if (likely(tp->srtt_us))
+		do_div(rate, tp->srtt_us);
+
+#ifdef SIM_LINUX_5_19
+	if(tp->suss_state != 2)	/* as the suss line of 5.19 */
+#else
+	if(tp->suss_state != 2 && tp->suss_state != 6) /* as line C1 */
+#endif
+	WRITE_ONCE(sk->sk_pacing_rate,
+		   min_t(u64, rate, READ_ONCE(sk->sk_max_pacing_rate)));
+}
+
+static void tcp_rearm_rto(struct sim_sock *s)
+{
+	struct tcp_sock *tp = &s->tp;
+
+	if (!tp->packets_out)
+		s->rto_ns = 0;
+	else
+		s->rto_ns = tp->tcp_clock_cache + (u64)tp->inet_conn.icsk_rto * NSEC_PER_USEC;
+}
+
+/* net/ipv4/tcp_input.c: cwnd reduction */
+static void tcp_init_cwnd_reduction(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+
+	tp->high_seq = tp->snd_nxt;
+	tp->snd_cwnd_cnt = 0;
+	tp->prior_cwnd = tcp_snd_cwnd(tp);
+	tp->prr_delivered = 0;
+	tp->prr_out = 0;
+	((struct sim_sock *)sk)->in.reduction = 1;
+	((struct sim_sock *)sk)->in.reduction_inflight = tcp_packets_in_flight(tp);
+	/* as block C3 */
+	u32 una = tp->snd_una - tp->snd_isn;
+	printk(KERN_INFO "SUSSmsg id=%u cwnd reduction. t=%llu Sport=%u cwnd=%u inf=%u state=%u d=%u loss=%u",
+	 tp->suss_msg_id, tp->tcp_mstamp, inet_sk(sk)->inet_sport, tp->snd_cwnd, tcp_packets_in_flight(tp), tp->suss_state, una, tp->lost);
+	if((tp->suss_state > 0) && (tp->suss_state < 9))
+	{
+	    if(tp->suss_state < 3)
+		tp->snd_cwnd = tcp_packets_in_flight(tp);
+	    tp->suss_state = 9;
+	}
+	tcp_suss_cwnd_reduction(sk);
+	tp->snd_ssthresh = inet_csk(sk)->icsk_ca_ops->ssthresh(sk);
+	tcp_ecn_queue_cwr(tp);
+}
+
+static void tcp_cwnd_reduction(struct sock *sk, int newly_acked_sacked, int newly_lost, int flag)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	int sndcnt = 0;
+	int delta = tp->snd_ssthresh - tcp_packets_in_flight(tp);
+
+	if (newly_acked_sacked <= 0 || WARN_ON_ONCE(!tp->prior_cwnd))
+		return;
+
+	tp->prr_delivered += newly_acked_sacked;
+	if (delta < 0) {
+		u64 dividend = (u64)tp->snd_ssthresh * tp->prr_delivered +
+			       tp->prior_cwnd - 1;
+		sndcnt = div_u64(dividend, tp->prior_cwnd) - tp->prr_out;
+	} else {
+		sndcnt = max_t(int, tp->prr_delivered - tp->prr_out,
+			       newly_acked_sacked);
+		if (flag & FLAG_SND_UNA_ADVANCED && !newly_lost)
+			sndcnt++;
+		sndcnt = min(delta, sndcnt);
+	}
+	/* Force a fast retransmit upon entering fast recovery */
+	sndcnt = max(sndcnt, (tp->prr_out ? 0 : 1));
+	tcp_snd_cwnd_set(tp, tcp_packets_in_flight(tp) + sndcnt);
+}
+
+static void tcp_end_cwnd_reduction(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+
+	/* Reset cwnd to ssthresh in CWR or Recovery (unless it's undone) */
+	if (tp->snd_ssthresh < TCP_INFINITE_SSTHRESH &&
+	    (inet_csk(sk)->icsk_ca_state == TCP_CA_CWR || tp->undo_marker)) {
+		tcp_snd_cwnd_set(tp, tp->snd_ssthresh);
+		tp->snd_cwnd_stamp = tcp_jiffies32;
+	}
+	tcp_ca_event(sk, CA_EVENT_COMPLETE_CWR);
+}
+
+static void tcp_enter_cwr(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+
+	tp->prior_ssthresh = 0;
+	if (inet_csk(sk)->icsk_ca_state < TCP_CA_CWR) {
+		tp->undo_marker = 0;
+		tcp_init_cwnd_reduction(sk);
+		tcp_set_ca_state(sk, TCP_CA_CWR);
+	}
+}
+
+static void tcp_enter_recovery(struct sock *sk)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+
+	tp->prior_ssthresh = 0;
+	tp->undo_marker = tp->snd_una;
+	if (!tcp_in_cwnd_reduction(sk))
+		tcp_init_cwnd_reduction(sk);
+	tcp_set_ca_state(sk, TCP_CA_Recovery);
+}
+
+/* Marks a segment lost: it is retransmitted next (tcp_mark_skb_lost) */
+static void sim_mark_lost(struct sim_sock *s, u32 idx)
+{
+	struct tcp_sock *tp = &s->tp;
+	u8 *st = &s->state[idx];
+
+	if (*st & SIM_RETRANS) {
+		*st &= ~SIM_RETRANS;
+		tp->retrans_out--;
+	}
+	if (!(*st & SIM_LOST)) {
+		*st |= SIM_LOST;
+		tp->lost_out++;
+	}
+	tp->lost++;
+	s->rtx_hint = min(s->rtx_hint, idx);
+}
+
+/* RACK (tcp_rack_detect_loss): a segment is lost if a segment that was sent
+ * after it is delivered. There is no reordering window once three segments
+ * are SACKed or in recovery; below that, the segments are left to the RTO. */
+static void sim_rack_detect_loss(struct sim_sock *s)
+{
+	struct tcp_sock *tp = &s->tp;
+	u32 idx;
+
+	if (!tp->sacked_out ||
+	    (tp->sacked_out < 3 && tp->inet_conn.icsk_ca_state < TCP_CA_Recovery))
+		return;
+
+	for (idx = s->una; idx < s->nxt; idx++) {
+		u8 st = s->state[idx];
+
+		if ((st & SIM_SACKED) || (st & (SIM_LOST | SIM_RETRANS)) == SIM_LOST)
+			continue;
+		if (s->xmit_ns[idx] >= s->rack_ns) {
+			/* Neither this one nor the later ones were sent before */
+			if (!(st & SIM_EVER_RETRANS))
+				break;
+			continue;
+		}
+		sim_mark_lost(s, idx);
+	}
+}
+
+static void sim_rack_advance(struct sim_sock *s, u32 idx)
+{
+	if (s->state[idx] & SIM_EVER_RETRANS)
+		return;
+	if (s->xmit_ns[idx] > s->rack_ns) {
+		s->rack_ns = s->xmit_ns[idx];
+		s->rack_rtt_us = div_u64(s->tp.tcp_clock_cache - s->rack_ns, NSEC_PER_USEC);
+	}
+}
+
+/* net/ipv4/tcp_input.c: RTO */
+static void tcp_enter_loss(struct sock *sk)
+{
+	struct sim_sock *s = (struct sim_sock *)sk;
+	const struct inet_connection_sock *icsk = inet_csk(sk);
+	struct tcp_sock *tp = tcp_sk(sk);
+	u32 idx;
+
+	/* tcp_timeout_mark_lost: the head and what was sent an RTT ago */
+	for (idx = s->una; idx < s->nxt; idx++) {
+		if (s->state[idx] & SIM_SACKED)
+			continue;
+		if (idx != s->una &&
+		    s->xmit_ns[idx] + (u64)s->rack_rtt_us * NSEC_PER_USEC > tp->tcp_clock_cache)
+			continue;
+		sim_mark_lost(s, idx);
+	}
+
+	/* Reduce ssthresh if it has not yet been made inside this window. */
+	if (icsk->icsk_ca_state <= TCP_CA_Disorder ||
+	    !after(tp->high_seq, tp->snd_una) ||
+	    (icsk->icsk_ca_state == TCP_CA_Loss && !icsk->icsk_retransmits)) {
+		tp->prior_ssthresh = 0;
+		tp->prior_cwnd = tcp_snd_cwnd(tp);
+		tp->snd_ssthresh = icsk->icsk_ca_ops->ssthresh(sk);
+		tcp_ca_event(sk, CA_EVENT_LOSS);
+		tp->undo_marker = tp->snd_una;
+	}
+#ifdef SIM_LINUX_5_19
+	/* as the suss block of 5.19 */
+	if((tp->suss_state > 0 && tp->suss_state < 10) && tp->snd_cwnd < 40)
+	    tp->suss_state = 10;
+#else
+	/* as block C2 */
+	tcp_suss_cwnd_reduction(sk);
+	if(tp->suss_state > 0 && tp->suss_state < 10) {
+	    if((tp->suss_state == 5) || (tp->suss_state == 6) || tp->snd_cwnd < 40)
+		tp->suss_state = 10;
+	    else
+		tp->suss_state = 5;
+	}
+#endif
+	printk(KERN_INFO "SUSSmsg id=%u Entered loss state. t=%llu Sport=%u cwnd=%u inf=%u state=%u loss=%u tcp_in_slow_start=%u",
+	 tp->suss_msg_id, tp->tcp_mstamp, inet_sk(sk)->inet_sport, tp->snd_cwnd, tcp_packets_in_flight(tp), tp->suss_state, tp->lost, tcp_in_slow_start(tp));
+
+	tcp_snd_cwnd_set(tp, tcp_packets_in_flight(tp) + 1);
+	tp->snd_cwnd_cnt   = 0;
+	tp->snd_cwnd_stamp = tcp_jiffies32;
+
+	tcp_set_ca_state(sk, TCP_CA_Loss);
+	tcp_suss_enter_loss(sk);	/* as line C6 */
+	tp->high_seq = tp->snd_nxt;
+	tcp_ecn_queue_cwr(tp);
+}
+
+static void sim_rto(struct sim_sock *s, uint64_t now_ns)
+{
+	struct sock *sk = sim_sk(s);
+	struct inet_connection_sock *icsk = inet_csk(sk);
+
+	sim_clock(s, now_ns);
+	if (!s->tp.packets_out) {
+		s->rto_ns = 0;
+		return;
+	}
+	tcp_enter_loss(sk);
+	icsk->icsk_retransmits++;
+	icsk->icsk_backoff++;
+	icsk->icsk_rto = min(icsk->icsk_rto << 1, TCP_RTO_MAX_US);
+	tcp_rearm_rto(s);
+}
+
+/* net/ipv4/tcp_output.c */
+static void tcp_update_skb_after_send(struct sock *sk, struct sk_buff *skb,
+				      u64 prior_wstamp)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+
+	if (sk->sk_pacing_status != SK_PACING_NONE) {
+		unsigned long rate = READ_ONCE(sk->sk_pacing_rate);
+
+		/* Original sch_fq does not pace first 10 MSS */
+		if (rate != ~0UL && rate && tp->data_segs_out >= 10) {
+			u64 len_ns = div64_ul((u64)skb->len * NSEC_PER_SEC, rate);
+			u64 credit = tp->tcp_wstamp_ns - prior_wstamp;
+
+			/* take into account OS jitter */
+			len_ns -= min_t(u64, len_ns / 2, credit);
+			tp->tcp_wstamp_ns += len_ns;
+		}
+	}
+#ifndef SIM_LINUX_5_19
+	/* as block D4, with the clock of the event for tcp_clock_ns() */
+	if ((tp->suss_state == 2) && (sk->sk_pacing_status == SK_PACING_NEEDED)) {
+	    struct tcp_suss *ss = tp->suss;
+
+	    if (!ss->red_pkts)
+		ss->red_first_ns = tp->tcp_clock_cache;
+	    ss->red_last_ns = tp->tcp_clock_cache;
+	    ss->red_last_segs = tcp_skb_pcount(skb);
+	    ss->red_pkts += tcp_skb_pcount(skb);
+	}
+#endif
+	/* as block D1 */
+	if((tp->snd_cwnd < tp->suss_limit) && (tp->suss_state == 2) &&
+	(tp->snd_cwnd <= (tcp_packets_in_flight(tp)+tcp_skb_pcount(skb))))
+	{
+            tp->snd_cwnd  = tp->snd_cwnd + 2;
+	    if (sk->sk_pacing_status == SK_PACING_NONE)
+	    {
+		printk(KERN_INFO "SUSSmsg id=%u Switch to pacing mode. t=%llu Sport=%u c=%u i=%u",
+		 tp->suss_msg_id, tp->tcp_mstamp, inet_sk(sk)->inet_sport, tp->snd_cwnd, tcp_packets_in_flight(tp));
+		cmpxchg(&sk->sk_pacing_status, SK_PACING_NONE, SK_PACING_NEEDED);
+		sk->sk_pacing_rate = tp->suss_rate;
+		tp->tcp_wstamp_ns = tp->suss_pacing_start_ns;
+	    }
+	}
+}
+
+static void tcp_cwnd_validate(struct sock *sk, bool is_cwnd_limited)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+
+	/* Track the strongest available signal of the degree to which the cwnd
+	 * is fully utilized. If cwnd-limited then remember that fact for the
+	 * current window. If not cwnd-limited then track the maximum number of
+	 * outstanding packets in the current window.
+	 */
+	if (!before(tp->snd_una, tp->cwnd_usage_seq) ||
+	    is_cwnd_limited ||
+	    (!tp->is_cwnd_limited &&
+	     tp->packets_out > tp->max_packets_out)) {
+		tp->is_cwnd_limited = is_cwnd_limited;
+		tp->max_packets_out = tp->packets_out;
+		tp->cwnd_usage_seq = tp->snd_nxt;
+	}
+
+	if (tcp_is_cwnd_limited(sk)) {
+		/* Network is feed fully. */
+		tp->snd_cwnd_used = 0;
+		tp->snd_cwnd_stamp = tcp_jiffies32;
+	}
+}
+
+/* The next segment to send: the lost ones first (tcp_xmit_retransmit_queue),
+ * then new data within the receiver window and the limit of a replay (sim_ack).
+ * U32_MAX if there is none. */
+static u32 sim_next_segment(struct sim_sock *s)
+{
+	struct tcp_sock *tp = &s->tp;
+	u32 idx;
+
+	if (tp->lost_out) {
+		for (idx = max(s->rtx_hint, s->una); idx < s->nxt; idx++)
+			if ((s->state[idx] & (SIM_SACKED | SIM_LOST | SIM_RETRANS)) == SIM_LOST)
+				break;
+		s->rtx_hint = idx;
+		if (idx < s->nxt)
+			return idx;
+	}
+	if (s->nxt < s->segs && !after(sim_seq(s, s->nxt + 1), tp->snd_una + tp->snd_wnd) &&
+	    (!s->nxt_max || s->nxt < s->nxt_max))
+		return s->nxt;
+	return U32_MAX;
+}
+
+static void sim_transmit(struct sim_sock *s, u32 idx,
+			 void (*emit)(void *ctx, const struct sim_seg *seg), void *ctx)
+{
+	struct sock *sk = sim_sk(s);
+	struct tcp_sock *tp = &s->tp;
+	struct sk_buff skb = { .cb = { .seq = sim_seq(s, idx), .end_seq = sim_seq(s, idx + 1) } };
+	struct sim_seg seg = { .idx = idx };
+	u32 prior_packets = tp->packets_out;
+	u32 prior_inflight = tcp_packets_in_flight(tp);
+	u64 prior_wstamp;
+
+	/* tcp_event_data_sent */
+	if (!tcp_packets_in_flight(tp))
+		tcp_ca_event(sk, CA_EVENT_TX_START);
+	tp->lsndtime = tcp_jiffies32;
+
+	/* __tcp_transmit_skb */
+	prior_wstamp = tp->tcp_wstamp_ns;
+	tp->tcp_wstamp_ns = max(tp->tcp_wstamp_ns, tp->tcp_clock_cache);
+	skb.skb_mstamp_ns = tp->tcp_wstamp_ns;
+	skb.len = skb.cb.end_seq - skb.cb.seq;
+	s->xmit_ns[idx] = skb.skb_mstamp_ns;
+
+	if (idx == s->nxt && (tp->ecn_flags & TCP_ECN_QUEUE_CWR)) {
+		/* tcp_ecn_send */
+		tp->ecn_flags &= ~TCP_ECN_QUEUE_CWR;
+		seg.cwr = 1;
+	}
+	tp->data_segs_out++;
+
+	tcp_update_skb_after_send(sk, &skb, prior_wstamp);
+
+	if (idx < s->nxt) {
+		/* tcp_retransmit_skb */
+		s->state[idx] |= SIM_RETRANS | SIM_EVER_RETRANS;
+		tp->retrans_out++;
+		tp->total_retrans++;
+		seg.retrans = 1;
+	} else {
+		/* tcp_event_new_data_sent */
+		s->nxt++;
+		tp->snd_nxt = skb.cb.end_seq;
+		tp->packets_out++;
+		if (!prior_packets)
+			tcp_rearm_rto(s);
+	}
+	if (tcp_in_cwnd_reduction(sk))
+		tp->prr_out++;
+
+	memset(&s->in, 0, sizeof(s->in));
+	s->in.acked = 1;
+	s->in.prior_inflight = prior_inflight;
+	sim_suss_input(s, SIM_SUSS_SEND);
+
+	seg.len = skb.len;
+	seg.time_ns = skb.skb_mstamp_ns;
+	emit(ctx, &seg);
+}
+
+static uint64_t sim_write_xmit(struct sim_sock *s, uint64_t now_ns,
+			       void (*emit)(void *ctx, const struct sim_seg *seg), void *ctx)
+{
+	struct sock *sk = sim_sk(s);
+	struct tcp_sock *tp = &s->tp;
+	bool is_cwnd_limited = false;
+	int sent_pkts = 0;
+	u64 next = 0;
+	u32 idx;
+
+	sim_clock(s, now_ns);
+	while ((idx = sim_next_segment(s)) != U32_MAX) {
+		/* tcp_pacing_check */
+		if (sk->sk_pacing_status == SK_PACING_NEEDED &&
+		    tp->tcp_wstamp_ns > tp->tcp_clock_cache) {
+			next = tp->tcp_wstamp_ns;
+			break;
+		}
+		if (tcp_packets_in_flight(tp) >= tcp_snd_cwnd(tp)) {
+			is_cwnd_limited = true;
+			break;
+		}
+		sim_transmit(s, idx, emit, ctx);
+		sent_pkts++;
+	}
+
+	is_cwnd_limited |= (tcp_packets_in_flight(tp) >= tcp_snd_cwnd(tp));
+	if (sent_pkts || is_cwnd_limited)
+		tcp_cwnd_validate(sk, is_cwnd_limited);
+	return next;
+}
+
+/* tcp_ack(), with tcp_sacktag_write_queue, tcp_clean_rtx_queue,
+ * tcp_fastretrans_alert and tcp_cong_control */
+static void sim_ack(struct sim_sock *s, uint64_t now_ns, const struct sim_ack *ack)
+{
+	struct sock *sk = sim_sk(s);
+	struct inet_connection_sock *icsk = inet_csk(sk);
+	struct tcp_sock *tp = &s->tp;
+	u32 prior_snd_una = tp->snd_una;
+	u32 prior_delivered = tp->delivered;
+	u32 prior_lost = tp->lost;
+	u32 cum = min(ack->cum, s->nxt);
+	u64 first_ackt = 0, last_ackt = 0, sackt = 0;
+	long seq_rtt_us = -1L, ca_rtt_us = -1L;
+	u32 pkts_acked = 0, ack_ev_flags, delivered, idx;
+	int flag = 0;
+
+	sim_clock(s, now_ns);
+	s->nxt_max = ack->nxt;
+	memset(&s->in, 0, sizeof(s->in));
+
+	/* tcp_sacktag_write_queue */
+	idx = ack->sack;
+	if (idx != U32_MAX && idx >= max(cum, s->una) && idx < s->nxt &&
+	    !(s->state[idx] & SIM_SACKED)) {
+		u8 *st = &s->state[idx];
+
+		if (!(*st & (SIM_RETRANS | SIM_EVER_RETRANS)))
+			sackt = s->xmit_ns[idx];
+		if (*st & SIM_RETRANS) {
+			*st &= ~SIM_RETRANS;
+			tp->retrans_out--;
+		}
+		if (*st & SIM_LOST) {
+			*st &= ~SIM_LOST;
+			tp->lost_out--;
+		}
+		*st |= SIM_SACKED;
+		tp->sacked_out++;
+		tp->delivered++;
+		sim_rack_advance(s, idx);
+		flag |= FLAG_DATA_SACKED;
+	}
+
+	if (cum > s->una) {
+		flag |= FLAG_SND_UNA_ADVANCED;
+		icsk->icsk_retransmits = 0;
+		tp->snd_una = sim_seq(s, cum);
+	}
+
+	/* tcp_in_ack_event */
+	ack_ev_flags = CA_ACK_WIN_UPDATE;
+	if (flag & FLAG_DATA_SACKED || ack->ece || !(flag & FLAG_SND_UNA_ADVANCED)) {
+		flag |= FLAG_SLOWPATH;
+		ack_ev_flags = CA_ACK_SLOWPATH;
+		if (ack->ece && (tp->ecn_flags & TCP_ECN_OK)) {
+			flag |= FLAG_ECE;
+			ack_ev_flags |= CA_ACK_ECE;
+		}
+	}
+	if (icsk->icsk_ca_ops->in_ack_event)
+		icsk->icsk_ca_ops->in_ack_event(sk, ack_ev_flags);
+	s->in.prior_inflight = tcp_packets_in_flight(tp);
+	s->in.ece = !!(ack_ev_flags & CA_ACK_ECE);
+	tcp_suss_in_ack_event(sk, ack_ev_flags);	/* as line C5 */
+
+	/* tcp_clean_rtx_queue */
+	for (idx = s->una; idx < cum; idx++) {
+		u8 st = s->state[idx];
+
+		if (st & (SIM_RETRANS | SIM_EVER_RETRANS)) {
+			if (st & SIM_RETRANS)
+				tp->retrans_out--;
+			flag |= FLAG_RETRANS_DATA_ACKED;
+		} else if (!(st & SIM_SACKED)) {
+			last_ackt = s->xmit_ns[idx];
+			if (!first_ackt)
+				first_ackt = last_ackt;
+		}
+
+		if (st & SIM_SACKED) {
+			tp->sacked_out--;
+		} else {
+			tp->delivered++;
+			sim_rack_advance(s, idx);
+		}
+		if (st & SIM_LOST)
+			tp->lost_out--;
+
+		tp->packets_out--;
+		pkts_acked++;
+		flag |= FLAG_DATA_ACKED;
+	}
+	s->una = max(s->una, cum);
+
+	if (first_ackt && !(flag & FLAG_RETRANS_DATA_ACKED)) {
+		seq_rtt_us = div_u64(tp->tcp_clock_cache - first_ackt, NSEC_PER_USEC);
+		ca_rtt_us = div_u64(tp->tcp_clock_cache - last_ackt, NSEC_PER_USEC);
+	}
+	if (sackt) {
+		ca_rtt_us = div_u64(tp->tcp_clock_cache - sackt, NSEC_PER_USEC);
+		if (seq_rtt_us < 0)
+			seq_rtt_us = ca_rtt_us;
+	}
+	/* The sample nearest to that of the send times among those that take
+	 * srtt to the recorded value (tcp_rtt_estimator), and the last segment
+	 * acked as much earlier as it was sent later */
+	if (ack->srtt_us && seq_rtt_us >= 0 && tp->srtt_us) {
+		long lo = ((long)ack->srtt_us << 3) - tp->srtt_us + (tp->srtt_us >> 3);
+		long m = max(clamp(seq_rtt_us, lo, lo + 7), 1L);
+
+		ca_rtt_us = max(ca_rtt_us - seq_rtt_us + m, 1L);
+		seq_rtt_us = m;
+	}
+	/* tcp_ack_update_rtt */
+	if (seq_rtt_us >= 0) {
+		tcp_rtt_estimator(sk, seq_rtt_us);
+		tcp_set_rto(sk);
+		icsk->icsk_backoff = 0;
+	}
+	if (flag & FLAG_DATA_ACKED)
+		tcp_rearm_rto(s);
+
+	s->in.inflight = tcp_packets_in_flight(tp);
+	s->in.rtt_us = ca_rtt_us;
+	s->in.pacing_rate = sk->sk_pacing_rate;
+	tcp_suss_acked(sk, ca_rtt_us);	/* as line C4 */
+	if (icsk->icsk_ca_ops->pkts_acked) {
+		struct ack_sample sample = { .pkts_acked = pkts_acked,
+					     .rtt_us = ca_rtt_us };
+
+		sample.in_flight = tp->mss_cache * (tp->delivered - prior_delivered);
+		icsk->icsk_ca_ops->pkts_acked(sk, &sample);
+	}
+
+	/* tcp_fastretrans_alert: leave CWR, Recovery and Loss once high_seq is
+	 * acked, enter Recovery on a loss and CWR on an ECE */
+	sim_rack_detect_loss(s);
+	if (icsk->icsk_ca_state != TCP_CA_Open && !before(tp->snd_una, tp->high_seq)) {
+		switch (icsk->icsk_ca_state) {
+		case TCP_CA_CWR:
+			if (tp->snd_una != tp->high_seq) {
+				tcp_end_cwnd_reduction(sk);
+				tcp_set_ca_state(sk, TCP_CA_Open);
+			}
+			break;
+		case TCP_CA_Recovery:
+			tcp_set_ca_state(sk, TCP_CA_Open);
+			tcp_end_cwnd_reduction(sk);
+			break;
+		case TCP_CA_Loss:
+			tcp_set_ca_state(sk, TCP_CA_Open);
+			break;
+		}
+	}
+	if (icsk->icsk_ca_state < TCP_CA_Recovery) {
+		if (tp->lost_out)
+			tcp_enter_recovery(sk);
+		else if (flag & FLAG_ECE)
+			tcp_enter_cwr(sk);
+	}
+
+	/* tcp_cong_control */
+	delivered = tp->delivered - prior_delivered;
+	if (tcp_in_cwnd_reduction(sk))
+		tcp_cwnd_reduction(sk, delivered, tp->lost - prior_lost, flag);
+	else if (flag & FLAG_DATA_ACKED)
+		icsk->icsk_ca_ops->cong_avoid(sk, tp->snd_una, delivered);
+	tcp_update_pacing_rate(sk);
+
+	s->in.acked = delivered;
+	sim_suss_input(s, SIM_SUSS_ACK);
+}
+
+static struct sim_sock *sim_connect(const struct sim_conn *conn, uint64_t now_ns)
+{
+	const struct tcp_congestion_ops *ca = sim_ca_find(conn->cc);
+	struct sim_sock *s;
+	struct sock *sk;
+	struct tcp_sock *tp;
+
+	if (!ca || !conn->mss || !conn->bytes)
+		return NULL;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return NULL;
+	s->bytes = conn->bytes;
+	s->segs = DIV_ROUND_UP(conn->bytes, conn->mss);
+	s->state = calloc(s->segs, sizeof(*s->state));
+	s->xmit_ns = calloc(s->segs, sizeof(*s->xmit_ns));
+	if (!s->state || !s->xmit_ns) {
+		free(s->state);
+		free(s->xmit_ns);
+		free(s);
+		return NULL;
+	}
+
+	sk = sim_sk(s);
+	tp = &s->tp;
+	sk->sk_family = AF_INET;
+	sk->sk_daddr = conn->daddr;
+	sk->sk_pacing_status = SK_PACING_NONE;
+	sk->sk_max_pacing_rate = ~0UL;
+	sk->sk_gso_max_size = 65536;
+	inet_sk(sk)->inet_sport = conn->sport;
+	inet_sk(sk)->inet_dport = conn->dport;
+
+	tp->mss_cache = conn->mss;
+	tp->snd_una = tp->snd_nxt = SIM_ISN;
+	tp->write_seq = SIM_ISN + conn->bytes;
+	tp->snd_wnd = conn->rwnd;
+	tp->snd_cwnd = TCP_INIT_CWND;
+	tp->snd_ssthresh = TCP_INFINITE_SSTHRESH;
+	tp->snd_cwnd_clamp = ~0U;
+	tp->cwnd_usage_seq = tp->snd_nxt;
+	if (conn->ecn)
+		tp->ecn_flags = TCP_ECN_OK;
+	if (conn->size_hint == SIM_HINT_FIN) {
+		s->fin.cb.seq = s->fin.cb.end_seq = tp->write_seq;
+		s->fin.cb.tcp_flags = TCPHDR_FIN;
+		sk->sk_write_tail = &s->fin;
+	} else if (conn->size_hint == SIM_HINT_SIZE) {
+#ifndef SIM_LINUX_5_19
+		tcp_suss_set_flow_size(sk, conn->bytes);
+#endif
+	}
+
+	sim_clock(s, now_ns);
+	inet_csk(sk)->icsk_rto = TCP_TIMEOUT_INIT_US;
+	if (conn->syn_rtt_us) {
+		tcp_rtt_estimator(sk, conn->syn_rtt_us);
+		tcp_set_rto(sk);
+	}
+	s->rack_rtt_us = conn->syn_rtt_us;
+
+	inet_csk(sk)->icsk_ca_ops = ca;
+	tcp_init_congestion_control(sk);
+	tcp_update_pacing_rate(sk);
+
+	s->in.rtt_us = conn->syn_rtt_us;
+	sim_suss_input(s, SIM_SUSS_START);
+	return s;
+}
+
+static void sim_close(struct sim_sock *s)
+{
+	if (!s)
+		return;
+	tcp_cleanup_congestion_control(sim_sk(s));
+	free(s->state);
+	free(s->xmit_ns);
+	free(s);
+}
+
+static uint64_t sim_rto_time(const struct sim_sock *s)
+{
+	return s->rto_ns;
+}
+
+static void sim_info(const struct sim_sock *s, struct sim_info *info)
+{
+	const struct tcp_sock *tp = &s->tp;
+
+	info->id = tp->suss_msg_id;
+	info->cwnd = tcp_snd_cwnd(tp);
+	info->ssthresh = tp->snd_ssthresh;
+	info->inflight = tcp_packets_in_flight(tp);
+	info->acked = s->una;
+	info->srtt_us = tp->srtt_us >> 3;
+	info->lost = tp->lost;
+	info->retrans = tp->total_retrans;
+	info->ca_state = tp->inet_conn.icsk_ca_state;
+	info->suss_state = tp->suss_state;
+#ifdef SIM_LINUX_5_19
+	/* The state of SUSS is the one of CUBIC */
+	info->suss_jumps = info->suss_round = 0;
+	if (tp->inet_conn.icsk_ca_ops == &cubictcp) {
+		const struct bictcp *ca = inet_csk_ca((const struct sock *)tp);
+
+		info->suss_jumps = ca->suss_num_of_jump;
+		info->suss_round = ca->suss_round_no;
+	}
+#else
+	info->suss_jumps = tcp_suss_jumps(tp);
+	info->suss_round = tp->suss_log ? tp->suss->round_no : 0;
+#endif
+	info->pacing_rate = tp->inet_conn.icsk_inet.sk.sk_pacing_rate;
+	info->slow_start = tcp_in_slow_start(tp);
+#ifdef SIM_LINUX_5_19
+	info->suss_cap = 0;
+#else
+	info->suss_cap = tp->suss_log && tp->suss->flag ? tp->suss->cap : 0;
+#endif
+	info->suss_limit = tp->suss_limit;
+	info->suss_paced = tp->inet_conn.icsk_inet.sk.sk_pacing_status == SK_PACING_NEEDED;
+	info->suss_pacing_start_ns = tp->suss_pacing_start_ns;
+}
+
+#ifndef SIM_LINUX_5_19
+/* The sysctls of the netns, set when the modules are loaded */
+static int sim_hystart_plus = -1;	/* net.ipv4.tcp_cubic_hystart_plus */
+#endif
+
+/* The module parameters of the two files, and the sysctls */
+static const struct {
+	const char	*name;
+	int		*value;
+} sim_params[] = {
+	{ "suss",			&suss },
+	{ "suss_max",			&suss_max },
+#ifndef SIM_LINUX_5_19
+	{ "suss_max_cap",		&suss_max_cap },
+	{ "suss_kmax",			&suss_kmax },
+	{ "suss_rto",			&suss_rto },
+	{ "suss_gradient",		&suss_gradient },
+	{ "suss_rtt_win",		&suss_rtt_win },
+	{ "suss_stages",		&suss_stages },
+	{ "suss_budget",		&suss_budget },
+#endif
+	{ "fast_convergence",		&fast_convergence },
+	{ "beta",			&beta },
+	{ "initial_ssthresh",		&initial_ssthresh },
+	{ "bic_scale",			&bic_scale },
+	{ "tcp_friendliness",		&tcp_friendliness },
+	{ "hystart",			&hystart },
+	{ "hystart_detect",		&hystart_detect },
+	{ "hystart_low_window",		&hystart_low_window },
+	{ "hystart_ack_delta_us",	&hystart_ack_delta_us },
+#ifndef SIM_LINUX_5_19
+	{ "tcp_cubic_hystart_plus",	&sim_hystart_plus },
+#endif
+};
+
+static int sim_param(const char *name, int *value, int set)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(sim_params) / sizeof(sim_params[0]); i++) {
+		if (strcmp(sim_params[i].name, name))
+			continue;
+		if (set)
+			*sim_params[i].value = *value;
+		else
+			*value = *sim_params[i].value;
+		return 0;
+	}
+	return -1;
+}
+
+static void sim_load(void)
+{
+	sim_random = 0;
+	sim_pernet_reset();
+#ifndef SIM_LINUX_5_19
+	tcp_suss_register();
+#endif
+	cubictcp_register();
+#ifndef SIM_LINUX_5_19
+	sim_sysctl("tcp_cubic_hystart_plus", sim_hystart_plus);
+#endif
+	tcp_register_congestion_control(&tcp_reno);
+}
+
+static void sim_log(void (*fn)(void *ctx, const char *msg), void *ctx)
+{
+	sim_log_fn = fn;
+	sim_log_ctx = ctx;
+}
+
+#ifndef SIM_LINUX_5_19
+static void sim_input(void (*fn)(void *ctx, const struct sim_sock *s,
+				 const struct sim_suss_input *in), void *ctx)
+{
+	sim_input_fn = fn;
+	sim_input_ctx = ctx;
+}
+#endif
+
+const struct sim_kernel SIM_KERNEL = {
+	.tree		= SIM_TREE,
+	.param		= sim_param,
+	.load		= sim_load,
+	.log		= sim_log,
+	.connect	= sim_connect,
+	.close		= sim_close,
+	.write_xmit	= sim_write_xmit,
+	.ack		= sim_ack,
+	.rto_time	= sim_rto_time,
+	.rto		= sim_rto,
+	.info		= sim_info,
+#ifndef SIM_LINUX_5_19
+	.suss_input	= sim_input,
+#endif
+};
@@ -0,0 +1,164 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * The TCP sender of the simulator, with the congestion control and SUSS of a
+ * kernel source tree compiled in (see sim_kernel.c). The network, the receiver
+ * and the clock are the simulator's (see sim.hpp).
+ *
+ * Segments are numbered from 0 at the start of the flow; times are in ns of
+ * the simulated clock.
+ */
+#ifndef SIM_KERNEL_H
+#define SIM_KERNEL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct sim_sock;
+
+/* How SUSS learns the size of the flow (see suss_pkts_left) */
+enum sim_size_hint {
+	SIM_HINT_NONE,		/* unknown, as for a download that is written in chunks */
+	SIM_HINT_FIN,		/* the whole flow and its FIN are queued at the start */
+	SIM_HINT_SIZE,		/* the application calls tcp_suss_set_flow_size() */
+};
+
+struct sim_conn {
+	const char	*cc;		/* name of the congestion control, e.g., "cubic" */
+	uint32_t	mss;
+	uint32_t	bytes;		/* size of the flow */
+	uint32_t	rwnd;		/* receiver window (bytes) */
+	uint32_t	syn_rtt_us;	/* RTT of the handshake, 0 if none */
+	uint32_t	daddr;
+	uint16_t	sport;		/* as the kernel prints it, e.g., 20480 for port 80 */
+	uint16_t	dport;
+	int		size_hint;	/* enum sim_size_hint */
+	int		ecn;		/* ECN is negotiated */
+};
+
+/* A segment that the sender hands to the network */
+struct sim_seg {
+	uint32_t	idx;
+	uint32_t	len;
+	uint64_t	time_ns;	/* departure time (EDT) */
+	uint8_t		retrans;
+	uint8_t		cwr;
+};
+
+/* An ACK of the receiver: what it has in order, and the segment that it
+ * received out of order (SACK), if any.
+ *
+ * A replay can also give what a recorded sender did on the ACK: the smoothed
+ * RTT it had after it, and the first segment it had not sent yet when the
+ * next ACK came (a sender with TSO or TSQ holds back part of what cwnd lets
+ * go). The RTT sample of the ACK is then the one that moves srtt to the
+ * recorded value, and the sender sends no new segment from nxt on until the
+ * next ACK. */
+struct sim_ack {
+	uint32_t	cum;		/* segments received in order */
+	uint32_t	sack;		/* segment received out of order, or UINT32_MAX */
+	uint8_t		ece;
+	uint32_t	srtt_us;	/* recorded srtt after the ACK, or 0 */
+	uint32_t	nxt;		/* recorded limit of new segments, or 0 for none */
+};
+
+/* State of a connection for the results */
+struct sim_info {
+	uint32_t	id;		/* suss_msg_id, as in the SUSSmsg lines */
+	uint32_t	cwnd;
+	uint32_t	ssthresh;
+	uint32_t	inflight;
+	uint32_t	acked;		/* segments acked in order */
+	uint32_t	srtt_us;
+	uint32_t	lost;
+	uint32_t	retrans;
+	uint32_t	ca_state;
+	uint32_t	suss_state;
+	uint32_t	suss_jumps;
+	uint32_t	suss_round;
+	uint64_t	pacing_rate;
+	int		slow_start;
+	/* The decisions of SUSS */
+	uint32_t	suss_cap;	/* cap on cwnd, 0 if none is set (or linux-5.19.10) */
+	uint32_t	suss_limit;	/* cwnd that the red train grows to */
+	int		suss_paced;	/* the red train is paced (SK_PACING_NEEDED) */
+	uint64_t	suss_pacing_start_ns;
+};
+
+/* What SUSS is given when it starts, on a segment sent and on an ACK, with the
+ * meanings of the arguments of suss::controller (suss_controller.hpp) */
+enum sim_suss_event {
+	SIM_SUSS_START,		/* tcp_init_congestion_control */
+	SIM_SUSS_SEND,		/* tcp_update_skb_after_send, of a segment */
+	SIM_SUSS_ACK,		/* tcp_ack */
+};
+
+struct sim_suss_input {
+	int		event;		/* enum sim_suss_event */
+	uint64_t	now_ns;		/* tcp_clock_cache */
+	uint32_t	snd_una;	/* bytes, after the ACK */
+	uint32_t	snd_nxt;
+	uint32_t	acked;		/* segments delivered by the ACK */
+	uint32_t	prior_inflight;	/* at tcp_suss_in_ack_event, or before the segment */
+	uint32_t	inflight;	/* at tcp_suss_acked */
+	int32_t		rtt_us;		/* of tcp_suss_acked, < 0 if none; of the handshake on start */
+	uint32_t	srtt_us;	/* after the ACK */
+	uint32_t	snd_wnd;	/* bytes */
+	uint32_t	left;		/* suss_pkts_left() */
+	uint64_t	pacing_rate;	/* sk_pacing_rate at tcp_suss_acked */
+	uint8_t		ece;		/* CA_ACK_ECE of tcp_in_ack_event */
+	uint8_t		cwnd_limited;	/* tcp_is_cwnd_limited() in cong_avoid of Reno */
+	uint8_t		reduction;	/* the ACK started a cwnd reduction (block C3) */
+	uint32_t	reduction_inflight; /* in flight at block C3 */
+};
+
+struct sim_kernel {
+	const char *tree;
+	/* Gets (set == 0) or sets a module parameter. Returns -1 if there is none
+	 * of that name. */
+	int (*param)(const char *name, int *value, int set);
+	/* Resets the state of the modules (per destination table, netns budget)
+	 * and runs their init functions with the current parameters, as after
+	 * loading them. */
+	void (*load)(void);
+	/* Receives every printk of the kernel code, without the newline. */
+	void (*log)(void (*fn)(void *ctx, const char *msg), void *ctx);
+
+	struct sim_sock *(*connect)(const struct sim_conn *conn, uint64_t now_ns);
+	void (*close)(struct sim_sock *s);
+	/* Sends what cwnd, the receiver window and pacing let go now, like
+	 * tcp_write_xmit; emit() gets each segment. Returns the time at which
+	 * pacing lets the next segment go, or 0. */
+	uint64_t (*write_xmit)(struct sim_sock *s, uint64_t now_ns,
+			       void (*emit)(void *ctx, const struct sim_seg *seg), void *ctx);
+	void (*ack)(struct sim_sock *s, uint64_t now_ns, const struct sim_ack *ack);
+	/* Time of the retransmission timer, or 0 if it is not armed */
+	uint64_t (*rto_time)(const struct sim_sock *s);
+	void (*rto)(struct sim_sock *s, uint64_t now_ns);
+	void (*info)(const struct sim_sock *s, struct sim_info *info);
+	/* Receives what SUSS is given (see struct sim_suss_input) once it has
+	 * acted on it, for each connection. NULL for linux-5.19.10, whose SUSS
+	 * is part of CUBIC. */
+	void (*suss_input)(void (*fn)(void *ctx, const struct sim_sock *s,
+				      const struct sim_suss_input *in), void *ctx);
+};
+
+extern const struct sim_kernel sim_kernel_6_8;
+/* The same sender with the SUSS of sourceCode/linux-5.19.10, which is part
+ * of its tcp_cubic.c and has fewer module parameters */
+extern const struct sim_kernel sim_kernel_5_19;
+
+/* sim_kernel_6_8 and its copies with their own module state, one for each
+ * thread of a sweep (see sim_slot.h) */
+extern const struct sim_kernel *const sim_kernel_6_8_slots[];
+extern const unsigned int sim_kernel_6_8_nslots;
+/* The same for sim_kernel_5_19, with as many copies */
+extern const struct sim_kernel *const sim_kernel_5_19_slots[];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_KERNEL_H */
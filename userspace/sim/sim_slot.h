@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Renames the global symbols of sim_kernel.c when it is compiled with
+ * -DSIM_SLOT=n, so that the copies link together. Each copy has its own
+ * module state (the statics of tcp_suss.c and tcp_cubic.c), so the threads
+ * of a sweep can run a scenario each (see build.sh and sweep.hpp).
+ */
+#ifndef SIM_SLOT_H
+#define SIM_SLOT_H
+
+#define SIM_SLOT_CAT(a, b)		a##b
+#define SIM_SLOT_NAME(name, slot)	SIM_SLOT_CAT(name, slot)
+
+#define tcp_suss_init			SIM_SLOT_NAME(tcp_suss_init_, SIM_SLOT)
+#define tcp_suss_release		SIM_SLOT_NAME(tcp_suss_release_, SIM_SLOT)
+#define tcp_suss_cong_avoid		SIM_SLOT_NAME(tcp_suss_cong_avoid_, SIM_SLOT)
+#define tcp_suss_cap			SIM_SLOT_NAME(tcp_suss_cap_, SIM_SLOT)
+#define tcp_suss_acked			SIM_SLOT_NAME(tcp_suss_acked_, SIM_SLOT)
+#define tcp_suss_in_ack_event		SIM_SLOT_NAME(tcp_suss_in_ack_event_, SIM_SLOT)
+#define tcp_suss_cwnd_reduction		SIM_SLOT_NAME(tcp_suss_cwnd_reduction_, SIM_SLOT)
+#define tcp_suss_enter_loss		SIM_SLOT_NAME(tcp_suss_enter_loss_, SIM_SLOT)
+#define tcp_suss_set_flow_size		SIM_SLOT_NAME(tcp_suss_set_flow_size_, SIM_SLOT)
+#define sim_kernel_6_8			SIM_SLOT_NAME(sim_kernel_6_8_, SIM_SLOT)
+#define sim_kernel_5_19			SIM_SLOT_NAME(sim_kernel_5_19_, SIM_SLOT)
+
+#endif /* SIM_SLOT_H */
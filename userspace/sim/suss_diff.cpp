@@ -0,0 +1,401 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * suss_diff: runs the SUSS of sourceCode/linux-5.19.10 and of linux-6.8 on the
+ * same inputs, and reports the first decision on which they differ and what
+ * the difference costs in FCT.
+ *
+ *	suss_diff --rate 10,100,1000 --rtt 10,50,200 --size 1m,16m
+ *	suss_diff -v ../usageGuide/example/raw.suss1
+ *
+ * Without files, each point of the grid (as in suss_sweep) runs closed loop on
+ * both kernels. With files, each recorded flow is replayed through both
+ * kernels (see replay.hpp), so they see the same ACKs, and its path runs
+ * closed loop for the FCT: the min RTT of the recording and the highest rate
+ * at which its data was acked over an RTT. The decisions are those of
+ * replay.hpp; 6.8 is the reference of the comparison.
+ *
+ * The module parameters that only 6.8 has keep their defaults there and are
+ * skipped by 5.19. Both kernels run SUSS (suss=1) unless -p sets suss, or,
+ * with files, the recording did not. See userspace/README.md.
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "options.hpp"
+#include "replay.hpp"
+#include "sweep.hpp"
+
+static void usage(const char *prog)
+{
+	std::fprintf(stderr,
+		"Usage: %s [options] [FILE...]\n"
+		"Runs linux-5.19.10 and linux-6.8 on the points of a grid, or replays the\n"
+		"flows of the SUSSmsg lines of the files (kern.log or suss_sim -r) through\n"
+		"both. --rate, --rtt, --buffer, --size, --loss, --ecn and -p take lists as\n"
+		"in suss_sweep; with files only --buffer (of the closed loop run) and -p.\n"
+		"%s"
+		"  -p NAME=LIST       module parameter of tcp_suss or tcp_cubic, e.g., suss_max=1,2\n"
+		"                     or sysctl of the netns, e.g., tcp_cubic_hystart_plus=0,1\n"
+		"  --id N             with files, only the flow with this id\n"
+		"  --tol F            relative tolerance of the compared values (0.05)\n"
+		"  -v                 print the decisions of both kernels\n"
+		"  -j N               threads (one per core, at most %u)\n"
+		"Exits with 1 if the kernels decide differently on a point or flow.\n",
+		prog, sim::option_help, sim_kernel_6_8_nslots);
+	std::exit(2);
+}
+
+static const char *const axis_options[] = {
+	"--rate", "--rtt", "--buffer", "--size", "--loss", "--ecn",
+};
+
+/* A closed loop run on one kernel: its flows and their traces */
+struct side {
+	std::vector<sim::flow_result> flows;
+	std::vector<sim::replay::trace> traces;		/* per flow */
+	double fct_us = 0;				/* mean, 0 if a flow did not end */
+};
+
+struct job {
+	sim::u64 point;
+	const char *file = nullptr;
+	sim::replay::trace rec;		/* with a file */
+	side k68, k519;
+	sim::replay::trace out68, out519;	/* replays, with a file */
+	/* The traces that are compared, and their first difference */
+	const sim::replay::trace *a = nullptr, *b = nullptr;
+	sim::replay::diff d;
+};
+
+static void run_side(const sim::scenario &sc, side &s)
+{
+	std::vector<std::vector<sim::replay::trace>> traces(sc.flows);
+	std::vector<std::map<sim::u32, size_t>> index(sc.flows);
+
+	s.flows = sim::run(sc, [&](sim::u32 flow, sim::u64, const char *msg) {
+		sim::replay::add_line(traces[flow], index[flow], msg);
+	});
+	s.traces.assign(sc.flows, {});
+	for (sim::u32 f = 0; f < sc.flows; f++)
+		for (sim::replay::trace &tr : traces[f])
+			if (!tr.acks.empty()) {
+				s.traces[f] = std::move(tr);
+				break;
+			}
+	for (const sim::flow_result &r : s.flows) {
+		if (!r.done) {
+			s.fct_us = 0;
+			break;
+		}
+		s.fct_us += (double)r.fct_us / s.flows.size();
+	}
+}
+
+/* The path of a recorded flow, for the closed loop run */
+static void recorded_path(const sim::replay::trace &rec, sim::scenario &sc)
+{
+	const std::vector<sim::replay::ack_line> &acks = rec.acks;
+	sim::u32 min_rtt = UINT32_MAX;
+	double rate = 0;
+
+	for (const sim::replay::ack_line &a : acks)
+		if (a.min_rtt_us)
+			min_rtt = std::min(min_rtt, a.min_rtt_us);
+	if (min_rtt == UINT32_MAX)
+		min_rtt = 1000;
+	for (size_t i = 0, j = 0; i < acks.size(); i++) {
+		while (j + 1 < i && acks[i].t_us - acks[j + 1].t_us >= min_rtt)
+			j++;
+		if (acks[i].t_us - acks[j].t_us >= min_rtt && acks[i].una > acks[j].una)
+			rate = std::max(rate, (double)(acks[i].una - acks[j].una) /
+					      (acks[i].t_us - acks[j].t_us));
+	}
+	if (rate == 0 && acks.size() > 1 && acks.back().t_us > acks[0].t_us)
+		rate = (double)acks.back().una / (acks.back().t_us - acks[0].t_us);
+
+	sc.rtt_ms = min_rtt / 1e3;
+	if (rate > 0)
+		sc.rate_mbps = rate * 8;
+	sc.bytes = sim::replay::flow_bytes(rec);
+	sc.mss = sim::replay::flow_mss(rec, {});
+}
+
+static bool has_param(const sim::scenario &sc, const char *name)
+{
+	for (const auto &p : sc.params)
+		if (p.first == name)
+			return true;
+	return false;
+}
+
+static void run_job(job &j, const sim::sweep &sw, double tol, unsigned t)
+{
+	std::vector<double> values;
+	sim::scenario sc = sw.point(j.point, values);
+
+	if (j.file) {
+		sim::replay::options opt;
+
+		opt.params = sc.params;
+		j.out68 = sim::replay::run(sim_kernel_6_8_slots[t], j.rec, opt);
+		j.out519 = sim::replay::run(sim_kernel_5_19_slots[t], j.rec, opt);
+		j.a = &j.out68;
+		j.b = &j.out519;
+		recorded_path(j.rec, sc);
+		if (!has_param(sc, "suss"))
+			sc.params.insert(sc.params.begin(), { "suss", sim::replay::uses_suss(j.rec) });
+	} else if (!has_param(sc, "suss")) {
+		sc.params.insert(sc.params.begin(), { "suss", 1 });
+	}
+
+	sc.kernel = sim_kernel_6_8_slots[t];
+	run_side(sc, j.k68);
+	sc.kernel = sim_kernel_5_19_slots[t];
+	run_side(sc, j.k519);
+
+	if (j.file) {
+		j.d = sim::replay::compare(*j.a, *j.b, tol);
+		return;
+	}
+	/* The first flow that differs */
+	for (size_t f = 0; f < j.k68.traces.size(); f++) {
+		j.a = &j.k68.traces[f];
+		j.b = &j.k519.traces[f];
+		j.d = sim::replay::compare(*j.a, *j.b, tol);
+		if (!j.d.ok())
+			break;
+	}
+}
+
+/* The FCTs and the first difference, after the columns of the point */
+static void report(const job &j, double tol, bool verbose)
+{
+	using namespace sim::replay;
+	const diff &d = j.d;
+
+	if (j.k68.fct_us)
+		std::printf(" %.0f", j.k68.fct_us);
+	else
+		std::printf(" -");
+	if (j.k519.fct_us)
+		std::printf(" %.0f", j.k519.fct_us);
+	else
+		std::printf(" -");
+	if (j.k68.fct_us && j.k519.fct_us)
+		std::printf(" %.3f", j.k519.fct_us / j.k68.fct_us);
+	else
+		std::printf(" -");
+	if (!j.a) {
+		std::printf(" 0 same\n");
+		return;
+	}
+
+	std::printf(" %zu", d.matched);
+	if (d.ok()) {
+		std::printf(" same\n");
+	} else if (d.decision != SIZE_MAX) {
+		bool in_a = d.decision < j.a->decisions.size();
+		bool in_b = d.decision < j.b->decisions.size();
+		const trace &at = in_a ? *j.a : *j.b;
+		const decision &x = in_a ? j.a->decisions[d.decision] : j.b->decisions[d.decision];
+
+		std::printf(" %.1fms \"%s\" \"%s\"\n", at.time_us(x) / 1e3,
+			    in_a ? describe(j.a->decisions[d.decision]).c_str() : "-",
+			    in_b ? describe(j.b->decisions[d.decision]).c_str() : "-");
+	} else if (d.ack != SIZE_MAX) {
+		const ack_line &a = j.a->acks[d.ack];
+
+		std::printf(" %.1fms \"ack c=%u s=%u Rnd=%u\" -\n",
+			    (a.t_us - j.a->acks[0].t_us) / 1e3, a.cwnd, a.state, a.round);
+	} else {
+		std::printf(" - \"unpaired=%zu\" -\n", d.unpaired);
+	}
+	if (verbose)
+		print_decisions(stdout, *j.a, *j.b, tol, "linux-6.8", "linux-5.19.10");
+}
+
+int main(int argc, char **argv)
+{
+	sim::sweep sw;
+	std::vector<sim::axis> axes(std::size(axis_options));
+	std::vector<sim::axis> params;
+	std::vector<const char *> files;
+	double tol = 0.05;
+	long long only = -1;
+	unsigned threads = 0;
+	bool verbose = false, path_options = false;
+	std::string cmd = "suss_diff";
+
+	for (size_t k = 0; k < axes.size(); k++)
+		axes[k].name = axis_options[k] + 2;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string opt = argv[i];
+			bool axis = false;
+
+			if (opt == "-h" || opt == "--help")
+				usage(argv[0]);
+			if (opt == "-v") {
+				verbose = true;
+				continue;
+			}
+			if (opt[0] != '-') {
+				files.push_back(argv[i]);
+				continue;
+			}
+			if (i + 1 >= argc)
+				usage(argv[0]);
+			std::string arg = argv[++i];
+			cmd += " " + opt + " " + arg;
+
+			for (size_t k = 0; k < axes.size(); k++) {
+				if (opt != axis_options[k])
+					continue;
+				if (axes[k].name == "size")
+					axes[k].values = sim::parse_values(arg, sim::parse_bytes);
+				else
+					axes[k].values = sim::parse_values(arg);
+				axis = true;
+				path_options |= axes[k].name != "buffer";
+			}
+			if (axis)
+				continue;
+			if (sim::parse_option(sw.base, opt, arg)) {
+				path_options |= opt != "--cc" && opt != "--rwnd";
+				continue;
+			}
+			if (opt == "-p") {
+				size_t eq = arg.find('=');
+				sim::axis a;
+
+				sim::parse_param(sw.base, arg.substr(0, eq) + "=0");
+				a.name = arg.substr(0, eq);
+				a.values = sim::parse_values(arg.substr(eq + 1));
+				params.push_back(a);
+			} else if (opt == "--id") {
+				only = (long long)sim::parse_number(arg);
+			} else if (opt == "--tol") {
+				tol = sim::parse_number(arg);
+			} else if (opt == "-j") {
+				threads = (unsigned)sim::parse_number(arg);
+			} else {
+				usage(argv[0]);
+			}
+		}
+	} catch (const std::invalid_argument &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		usage(argv[0]);
+	}
+	if (!files.empty() && path_options) {
+		std::fprintf(stderr, "%s: the path of a recorded flow is that of the recording\n",
+			     argv[0]);
+		usage(argv[0]);
+	}
+
+	/* As in suss_sweep; with files the point is only the buffer and -p */
+	for (sim::axis &a : axes) {
+		if (a.values.empty()) {
+			if (a.name != "buffer" && !files.empty())
+				continue;
+			if (a.name == "loss" || a.name == "ecn")
+				continue;
+			if (a.name == "rate")
+				a.values = { sw.base.rate_mbps };
+			else if (a.name == "rtt")
+				a.values = { sw.base.rtt_ms };
+			else if (a.name == "buffer")
+				a.values = { sw.base.buffer_bdp };
+			else
+				a.values = { (double)sw.base.bytes };
+		}
+		sw.axes.push_back(a);
+	}
+	sw.axes.insert(sw.axes.end(), params.begin(), params.end());
+
+	std::vector<job> jobs;
+	try {
+		for (sim::u64 i = 0; i < sw.points(); i++) {
+			std::vector<double> values;
+
+			sim::check_scenario(sw.point(i, values));
+		}
+	} catch (const std::invalid_argument &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		usage(argv[0]);
+	}
+	if (files.empty()) {
+		for (sim::u64 i = 0; i < sw.points(); i++) {
+			jobs.emplace_back();
+			jobs.back().point = i;
+		}
+	}
+	for (const char *f : files) {
+		std::ifstream in(f);
+
+		if (!in) {
+			std::perror(f);
+			return 2;
+		}
+		for (sim::replay::trace &tr : sim::replay::read_log(in)) {
+			if (only >= 0 && tr.id != (sim::u32)only)
+				continue;
+			for (sim::u64 i = 0; i < sw.points(); i++) {
+				jobs.emplace_back();
+				jobs.back().point = i;
+				jobs.back().file = f;
+				jobs.back().rec = tr;
+			}
+		}
+	}
+
+	/* Each thread runs both kernels on its own copies of them */
+	if (!threads)
+		threads = std::max(1U, std::thread::hardware_concurrency());
+	threads = (unsigned)std::min<sim::u64>({ threads, sim_kernel_6_8_nslots,
+						 std::max<size_t>(jobs.size(), 1) });
+	sim::work_queues queues(threads, jobs.size());
+	std::vector<std::thread> workers;
+
+	for (unsigned t = 0; t < threads; t++)
+		workers.emplace_back([&, t] {
+			sim::u64 i;
+
+			while (queues.take(t, i))
+				run_job(jobs[i], sw, tol, t);
+		});
+	for (std::thread &w : workers)
+		w.join();
+
+	/* fct is the mean over the flows, "-" if a flow did not end; ratio is
+	 * 5.19 over 6.8; same is the number of decisions that are the same,
+	 * followed by the time of the first that differs and its value on
+	 * each kernel. */
+	std::printf("# %s\n#", cmd.c_str());
+	if (!files.empty())
+		std::printf(" file id");
+	for (const sim::axis &a : sw.axes)
+		std::printf(" %s", a.name.c_str());
+	std::printf(" fct_6_8_us fct_5_19_us ratio same first_ms linux-6.8 linux-5.19.10\n");
+
+	int ret = 0;
+	for (const job &j : jobs) {
+		std::vector<double> values;
+
+		sw.point(j.point, values);
+		if (j.file)
+			std::printf("%s %u ", j.file, j.rec.id);
+		for (size_t k = 0; k < values.size(); k++)
+			std::printf(k ? " %.10g" : "%.10g", values[k]);
+		report(j, tol, verbose);
+		if (!j.d.ok())
+			ret = 1;
+	}
+	return ret;
+}
@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * suss_lockstep: runs flows of the simulator with Reno and gives the SUSS of
+ * userspace/suss_controller.hpp what the SUSS of tcp_suss.c is given (its
+ * start, each segment sent and each ACK, see struct sim_suss_input). After
+ * each of them, cwnd, ssthresh, the state, the round, the jumps, the cap, the
+ * limit of the red train and its pacing (rate and start) have to be the same.
+ *
+ *	suss_lockstep
+ *	suss_lockstep --rate 100 --rtt 200 --hint fin -p suss_stages=4 -v
+ *
+ * Without options, a set of paths, flow size hints and module parameters is
+ * run. A flow is followed while it is in slow start, up to a cwnd reduction or
+ * an RTO: after it, the transport's congestion control takes over from the
+ * controller. See userspace/README.md.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "options.hpp"
+#include "../suss_controller.hpp"
+
+static void usage(const char *prog)
+{
+	std::fprintf(stderr,
+		"Usage: %s [options]\n"
+		"Without options, runs the paths, hints and parameters of the check.\n"
+		"%s"
+		"  -p NAME=VALUE      module parameter of tcp_suss, e.g., suss_gradient=1\n"
+		"  -v                 print the state after each event\n"
+		"The flow is a single one with Reno and suss=1. Exits with 1 on the first\n"
+		"decision that differs.\n",
+		prog, sim::option_help);
+	std::exit(2);
+}
+
+struct lockstep {
+	const sim_kernel *k;
+	suss::controller cc;
+	bool verbose = false;
+	bool started = false;
+	bool done = false;
+	const char *end = "flow";	/* why the flow is no longer followed */
+	sim::u64 events = 0;
+	std::string diff;		/* the first difference */
+
+	lockstep(const sim_kernel *k, const suss::config &cfg) : k(k), cc(cfg) { }
+
+	static void input(void *ctx, const sim_sock *s, const sim_suss_input *in)
+	{
+		static_cast<lockstep *>(ctx)->step(s, *in);
+	}
+
+	void step(const sim_sock *s, const sim_suss_input &in)
+	{
+		static const char *const names[] = { "start", "send", "ack" };
+		sim_info info;
+
+		if (done)
+			return;
+		k->info(s, &info);
+		/* An RTO (tcp_enter_loss) is not an input of the controller */
+		if (info.ca_state == 4 /* TCP_CA_Loss */) {
+			finish("rto");
+			return;
+		}
+
+		switch (in.event) {
+		case SIM_SUSS_START:
+			cc.start(in.now_ns, in.snd_una, (sim::u32)in.rtt_us);
+			started = true;
+			break;
+		case SIM_SUSS_SEND:
+			cc.on_packet_sent(in.now_ns, in.acked, in.prior_inflight);
+			break;
+		case SIM_SUSS_ACK: {
+			suss::ack_sample a;
+
+			a.now_ns = in.now_ns;
+			a.ack = in.snd_una;
+			a.snd_nxt = in.snd_nxt;
+			a.acked = in.acked;
+			a.prior_inflight = in.prior_inflight;
+			a.inflight = in.inflight;
+			a.rtt_us = in.rtt_us;
+			a.srtt_us = in.srtt_us;
+			a.ece = in.ece;
+			a.cwnd_limited = in.cwnd_limited;
+			a.snd_wnd = in.snd_wnd;
+			a.left = in.left;
+			a.host_pacing_rate = in.pacing_rate;
+			cc.on_ack(a);
+			if (in.reduction)
+				cc.on_loss(in.reduction_inflight);
+			break;
+		}
+		}
+		if (!started)
+			return;
+		events++;
+
+		if (verbose)
+			std::printf("%s t=%llu una=%u acked=%u rtt=%d c=%u/%u ss=%u/%u s=%u/%u Rnd=%u/%u "
+				    "jumps=%u/%u cap=%u/%u limit=%u/%u rate=%llu/%llu\n",
+				    names[in.event], (unsigned long long)in.now_ns, in.snd_una, in.acked,
+				    in.rtt_us, info.cwnd, cc.cwnd(), info.ssthresh, cc.ssthresh(),
+				    info.suss_state, cc.state(), info.suss_round, cc.round(),
+				    info.suss_jumps, cc.jumps(), info.suss_cap, cc.cap(),
+				    info.suss_limit, cc.limit(),
+				    (unsigned long long)(info.suss_paced ? info.pacing_rate : 0),
+				    (unsigned long long)cc.pacing_rate());
+
+		/* After a cwnd reduction, only the state is SUSS's */
+		if (in.event == SIM_SUSS_ACK && in.reduction) {
+			compare("state", info.suss_state, cc.state(), in);
+			finish("reduction");
+			return;
+		}
+		compare("cwnd", info.cwnd, cc.cwnd(), in);
+		compare("ssthresh", info.ssthresh, cc.ssthresh(), in);
+		compare("state", info.suss_state, cc.state(), in);
+		compare("round", info.suss_round, cc.round(), in);
+		compare("jumps", info.suss_jumps, cc.jumps(), in);
+		compare("cap", info.suss_cap, cc.cap(), in);
+		compare("limit", info.suss_limit, cc.limit(), in);
+		compare("pacing_rate", info.suss_paced ? info.pacing_rate : 0, cc.pacing_rate(), in);
+		compare("pacing_start_ns", info.suss_pacing_start_ns, cc.pacing_start_ns(), in);
+		if (!diff.empty())
+			finish("diff");
+		else if (!info.slow_start)
+			finish("slow start");
+	}
+
+	void compare(const char *what, sim::u64 kernel, sim::u64 controller, const sim_suss_input &in)
+	{
+		static const char *const names[] = { "start", "send", "ack" };
+		char buf[256];
+
+		if (kernel == controller || !diff.empty())
+			return;
+		std::snprintf(buf, sizeof(buf), "%s of %s %llu at %.3fms una=%u: kernel=%llu controller=%llu",
+			      what, names[in.event], (unsigned long long)events,
+			      in.now_ns / 1e6, in.snd_una,
+			      (unsigned long long)kernel, (unsigned long long)controller);
+		diff = buf;
+	}
+
+	void finish(const char *why)
+	{
+		done = true;
+		end = why;
+	}
+};
+
+/* The controller with the module parameters of the scenario */
+static suss::config make_config(const sim::scenario &sc)
+{
+	const sim_kernel *k = sc.kernel;
+	suss::config cfg;
+	int v;
+
+	cfg.mss = sc.mss;
+	k->param("suss", &v, 0);
+	cfg.enabled = v;
+	k->param("suss_max", &v, 0);
+	cfg.max_jumps = v;
+	k->param("suss_max_cap", &v, 0);
+	cfg.max_jumps_cap = v;
+	k->param("suss_gradient", &v, 0);
+	cfg.gradient = v;
+	k->param("suss_rtt_win", &v, 0);
+	cfg.rtt_win_ms = (sim::u32)v;
+	k->param("suss_stages", &v, 0);
+	cfg.stages = (sim::u32)v;
+	return cfg;
+}
+
+/* Runs the flow; prints a line and returns false if the two differ */
+static bool run(const sim::scenario &sc, bool verbose, const std::string &name)
+{
+	const sim_kernel *k = sc.kernel;
+
+	/* As the run sets them (see sim::engine::run) */
+	for (const auto &p : sc.params) {
+		int v = p.second;
+
+		k->param(p.first.c_str(), &v, 1);
+	}
+	lockstep ls(k, make_config(sc));
+
+	ls.verbose = verbose;
+	k->suss_input(&lockstep::input, &ls);
+	sim::run(sc);
+	k->suss_input(nullptr, nullptr);
+
+	std::printf("%s events=%llu jumps=%u cap=%u end=%s", name.c_str(),
+		    (unsigned long long)ls.events, ls.cc.jumps(), ls.cc.cap(), ls.end);
+	if (!ls.diff.empty() || !ls.started) {
+		std::printf(" differs: %s\n", ls.started ? ls.diff.c_str() : "no start");
+		return false;
+	}
+	std::printf(" same\n");
+	return true;
+}
+
+static sim::scenario base()
+{
+	sim::scenario sc;
+
+	sc.kernel = &sim_kernel_6_8;
+	sc.cc = "reno";
+	sc.bytes = 32 << 20;
+	/* The parameters that the runs change stay set after them */
+	sc.params = { { "suss", 1 }, { "suss_gradient", 0 }, { "suss_stages", 1 } };
+	return sc;
+}
+
+int main(int argc, char **argv)
+{
+	sim::scenario sc = base();
+	bool verbose = false, custom = false;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string opt = argv[i];
+
+			if (opt == "-h" || opt == "--help")
+				usage(argv[0]);
+			if (opt == "-v") {
+				verbose = true;
+				continue;
+			}
+			if (i + 1 >= argc)
+				usage(argv[0]);
+			std::string arg = argv[++i];
+
+			custom = true;
+			if (sim::parse_option(sc, opt, arg))
+				continue;
+			if (opt == "-p")
+				sc.params.push_back(sim::parse_param(sc, arg));
+			else
+				usage(argv[0]);
+		}
+		sim::check_scenario(sc);
+		if (sc.flows != 1 || sc.cc != "reno")
+			throw std::invalid_argument("the flow is a single one with Reno");
+	} catch (const std::invalid_argument &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		usage(argv[0]);
+	}
+
+	if (custom)
+		return run(sc, verbose, "scenario") ? 0 : 1;
+
+	/* Paths from a short RTT to a long fat one, with a buffer of one BDP and
+	 * of a tenth of it; a long flow of unknown size and a short one that
+	 * queues its FIN at the start, so that the jumps are cut to what is
+	 * left; the gradient, the pacing stages, ECN and a small receiver window */
+	static const struct {
+		const char *name;
+		const char *param;
+		int value;
+		double ecn;
+		sim::u32 rwnd;
+	} variants[] = {
+		{ "default", nullptr, 0, 0, 64 << 20 },
+		{ "gradient", "suss_gradient", 1, 0, 64 << 20 },
+		{ "stages", "suss_stages", 4, 0, 64 << 20 },
+		{ "ecn", nullptr, 0, 0.5, 64 << 20 },
+		{ "rwnd", nullptr, 0, 0, 1 << 20 },
+	};
+	int failed = 0;
+
+	for (double rate : { 10.0, 100.0, 1000.0 })
+		for (double rtt : { 20.0, 100.0, 300.0 })
+			for (double buffer : { 1.0, 0.1 })
+				for (int hint : { SIM_HINT_NONE, SIM_HINT_FIN })
+					for (const auto &var : variants) {
+						sim::scenario s = base();
+						char name[128];
+
+						s.rate_mbps = rate;
+						s.rtt_ms = rtt;
+						s.buffer_bdp = buffer;
+						s.size_hint = hint;
+						if (hint == SIM_HINT_FIN)
+							s.bytes = 2 << 20;
+						s.ecn_bdp = var.ecn;
+						s.rwnd = var.rwnd;
+						if (var.param)
+							s.params.push_back({ var.param, var.value });
+						std::snprintf(name, sizeof(name),
+							      "rate=%g rtt=%g buffer=%gbdp size=%s %s",
+							      rate, rtt, buffer,
+							      hint == SIM_HINT_FIN ? "2m/fin" : "32m/none",
+							      var.name);
+						if (!run(s, verbose, name))
+							failed = 1;
+					}
+	return failed;
+}
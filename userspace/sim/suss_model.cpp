@@ -0,0 +1,373 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * suss_model: the FCT and the end of slow start of model.hpp, for the points
+ * of a grid (in the table format of suss_sweep), for random points (to time
+ * it), or for the paths of recorded data.suss files (to check it).
+ *
+ *	suss_model --rate 10:100000:x10 --rtt 10,50,200 --size 1m,16m -p suss=0,1
+ *	suss_model --bench 10000000
+ *	suss_model --check ../../usageGuide/example/data.suss0 ../../usageGuide/example/data.suss1
+ *
+ * See userspace/README.md.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "model.hpp"
+#include "options.hpp"
+#include "sweep.hpp"
+
+static void usage(const char *prog)
+{
+	std::fprintf(stderr,
+		"Usage: %s [options]\n"
+		"The options --rate, --rtt, --buffer, --size and --iw, and suss and suss_max\n"
+		"take lists of values: a,b,c or lo:hi:xF (geometric) or lo:hi:+S (arithmetic).\n"
+		"The grid is all their combinations.\n"
+		"  --rate MBIT        bottleneck rate (100)\n"
+		"  --rtt MS           base RTT (50)\n"
+		"  --buffer N         bottleneck buffer in BDPs (1)\n"
+		"  --size N[k|m|g]    bytes per flow (16m)\n"
+		"  --iw N             initial window (10)\n"
+		"  --paced 0|1        slow start paced by fq (0: ACK clocked bursts)\n"
+		"  --mss N            (1448)\n"
+		"  -p NAME=LIST       suss, suss_max, suss_gradient or suss_max_cap\n"
+		"  -j N               threads (1, 0: one per core)\n"
+		"  -o FILE            the table (stdout)\n"
+		"  --bench N          time the model on N random points instead\n"
+		"  --check FILE...    compare the model with data.suss files instead\n",
+		prog);
+	std::exit(1);
+}
+
+static const char *const axis_options[] = {
+	"--rate", "--rtt", "--buffer", "--size", "--iw", "suss", "suss_max",
+};
+
+/* The columns of the grid, as suss_sweep: the last one varies fastest */
+static void fill_grid(const std::vector<sim::axis> &axes, sim::model::batch &in)
+{
+	size_t n = 1;
+
+	for (const sim::axis &a : axes)
+		n *= a.values.size();
+	in.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		size_t j = i;
+
+		for (size_t k = axes.size(); k-- > 0;) {
+			const sim::axis &a = axes[k];
+			double v = a.values[j % a.values.size()];
+
+			j /= a.values.size();
+			if (a.name == "rate")
+				in.rate_mbps[i] = v;
+			else if (a.name == "rtt")
+				in.rtt_ms[i] = v;
+			else if (a.name == "buffer")
+				in.buffer_bdp[i] = v;
+			else if (a.name == "size")
+				in.bytes[i] = v;
+			else if (a.name == "iw")
+				in.iw[i] = v;
+			else if (a.name == "suss")
+				in.suss[i] = v;
+			else
+				in.suss_max[i] = v;
+		}
+	}
+}
+
+static void bench(const sim::model::config &cfg, size_t n, unsigned threads)
+{
+	std::mt19937_64 rng(1);
+	std::uniform_real_distribution<double> u(0, 1);
+	sim::model::batch in;
+	sim::model::results out;
+	double sum = 0;
+
+	/* log uniform over 1 Mbit/s - 10 Gbit/s, 1 - 500 ms, 0.1 - 4 BDPs and
+	 * 10 KB - 1 GB */
+	in.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		in.rate_mbps[i] = std::pow(10, 4 * u(rng));
+		in.rtt_ms[i] = std::pow(500, u(rng));
+		in.buffer_bdp[i] = 0.1 * std::pow(40, u(rng));
+		in.bytes[i] = 1e4 * std::pow(1e5, u(rng));
+		in.suss[i] = u(rng) < 0.5;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	sim::model::run(cfg, in, out, threads);
+	std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+
+	for (double f : out.fct_us)
+		sum += std::isnan(f) ? 0 : f;
+	std::printf("%zu points in %.3f s: %.3g points/s, %.1f ns per point (%d lanes, mean fct_us %.0f)\n",
+		    n, secs.count(), n / secs.count(), secs.count() * 1e9 / n,
+		    sim::model::LANES, sum / n);
+}
+
+/* What a data.suss file (see extract.sh) says about its flow */
+struct trace {
+	double rtt_us = 1e18, max_rtt_us = 0, rate_mbps, bytes, fct_us;
+	double iw = 0, suss = 0, jumps = 0, exit_us = 0, exit_cwnd = 0;
+};
+
+static bool read_trace(const char *file, double mss, trace &tr)
+{
+	std::FILE *f = std::fopen(file, "r");
+	std::vector<std::map<std::string, double>> lines;
+	char buf[1024];
+	double last_round = -1;
+
+	if (!f) {
+		std::perror(file);
+		return false;
+	}
+	while (std::fgets(buf, sizeof(buf), f)) {
+		std::map<std::string, double> kv;
+		char *save, *key, *val;
+
+		for (key = strtok_r(buf, " \t\n", &save); key && (val = strtok_r(nullptr, " \t\n", &save));
+		     key = strtok_r(nullptr, " \t\n", &save))
+			kv[key] = std::strtod(val, nullptr);
+		if (kv.count("t") && kv.count("c") && kv.count("d"))
+			lines.push_back(kv);
+	}
+	std::fclose(f);
+	if (lines.size() < 2) {
+		std::fprintf(stderr, "%s: not a data.suss file\n", file);
+		return false;
+	}
+
+	for (auto &kv : lines) {
+		if (kv["minRTT"] > 0 && kv["minRTT"] < tr.rtt_us)
+			tr.rtt_us = kv["minRTT"];
+		tr.max_rtt_us = std::max(tr.max_rtt_us, kv["RTT"]);
+		if (kv["s"] != 10)
+			tr.suss = 1;
+		if (kv["s"] == 2 && kv["Rnd"] != last_round) {
+			tr.jumps++;
+			last_round = kv["Rnd"];
+		}
+	}
+	tr.iw = lines.front()["c"];
+	tr.bytes = lines.back()["d"];
+	/* t = 0 is the first ACK, about an RTT after the first packet, and the
+	 * last ACK comes half an RTT after the last byte */
+	tr.fct_us = lines.back()["t"] + tr.rtt_us / 2;
+
+	/* The rate of the second half, which keeps a queue */
+	const auto &mid = lines[lines.size() / 2], &end = lines.back();
+	tr.rate_mbps = (end.at("d") - mid.at("d")) * 8 / (end.at("t") - mid.at("t")) *
+		       (mss + sim::HEADER_BYTES) / mss;
+
+	/* Slow start ends at the first "stop" state (3 or 4), or else before the
+	 * first RTT in which cwnd grows by less than a tenth */
+	for (auto &kv : lines)
+		if (kv["s"] == 3 || kv["s"] == 4) {
+			tr.exit_cwnd = kv["c"];
+			tr.exit_us = kv["t"] + tr.rtt_us;
+			return true;
+		}
+	for (size_t i = 0, j = 0; i < lines.size(); i++) {
+		auto &kv = lines[i];
+
+		while (j < lines.size() && lines[j]["t"] < kv["t"] + tr.rtt_us)
+			j++;
+		if (j < lines.size() && kv["c"] >= 16 && lines[j]["c"] < 1.1 * kv["c"]) {
+			tr.exit_cwnd = kv["c"];
+			tr.exit_us = kv["t"] + tr.rtt_us;
+			break;
+		}
+	}
+	return true;
+}
+
+static void check(const sim::model::config &cfg, int argc, char **argv, int first)
+{
+	for (int i = first; i < argc; i++) {
+		sim::model::batch in;
+		sim::model::results out;
+		trace tr;
+
+		if (!read_trace(argv[i], cfg.mss, tr))
+			std::exit(1);
+		in.resize(1);
+		in.rate_mbps[0] = tr.rate_mbps;
+		in.rtt_ms[0] = tr.rtt_us / 1000;
+		/* no loss: the buffer held at least the largest queue */
+		in.buffer_bdp[0] = (tr.max_rtt_us - tr.rtt_us) / tr.rtt_us;
+		in.bytes[0] = tr.bytes;
+		in.iw[0] = tr.iw;
+		in.suss[0] = tr.suss;
+		sim::model::run(cfg, in, out);
+
+		auto row = [](const char *name, double trace, double model) {
+			std::printf("  %-10s %10.0f %10.0f %+7.1f%%\n", name, trace, model,
+				    trace ? 100 * (model - trace) / trace : 0);
+		};
+		std::printf("%s: rate=%.1f rtt=%.2f buffer=%.2f size=%.0f iw=%.0f suss=%.0f\n",
+			    argv[i], in.rate_mbps[0], in.rtt_ms[0], in.buffer_bdp[0], tr.bytes,
+			    tr.iw, tr.suss);
+		std::printf("  %-10s %10s %10s %8s\n", "", "trace", "model", "error");
+		row("fct_us", tr.fct_us, out.fct_us[0]);
+		row("ss_exit_us", tr.exit_us, out.exit_us[0]);
+		row("ss_cwnd", tr.exit_cwnd, out.exit_cwnd[0]);
+		row("jumps", tr.jumps, out.jumps[0]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	sim::model::config cfg;
+	std::vector<sim::axis> axes(std::size(axis_options));
+	unsigned threads = 1;
+	size_t bench_points = 0;
+	const char *out_file = nullptr;
+	std::FILE *out = stdout;
+	std::string cmd = "suss_model";
+	int check_from = 0;
+
+	for (size_t k = 0; k < axes.size(); k++)
+		axes[k].name = axis_options[k] + (axis_options[k][0] == '-' ? 2 : 0);
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string opt = argv[i];
+			bool axis = false;
+
+			if (opt == "--check") {
+				check_from = i + 1;
+				break;
+			}
+			if (opt == "-h" || opt == "--help" || i + 1 >= argc)
+				usage(argv[0]);
+			std::string arg = argv[++i];
+			cmd += " " + opt + " " + arg;
+
+			if (opt == "-p") {
+				size_t eq = arg.find('=');
+
+				opt = arg.substr(0, eq);
+				arg = eq == std::string::npos ? "" : arg.substr(eq + 1);
+			}
+			for (size_t k = 0; k < axes.size(); k++) {
+				if (opt != axis_options[k])
+					continue;
+				if (axes[k].name == "size")
+					axes[k].values = sim::parse_values(arg, sim::parse_bytes);
+				else
+					axes[k].values = sim::parse_values(arg);
+				axis = true;
+			}
+			if (axis)
+				continue;
+			if (opt == "--paced")
+				cfg.paced = sim::parse_number(arg) != 0;
+			else if (opt == "--mss")
+				cfg.mss = sim::parse_number(arg);
+			else if (opt == "suss_gradient")
+				cfg.suss_gradient = (int)sim::parse_number(arg);
+			else if (opt == "suss_max_cap")
+				cfg.suss_max_cap = (int)sim::parse_number(arg);
+			else if (opt == "-j")
+				threads = (unsigned)sim::parse_number(arg);
+			else if (opt == "-o")
+				out_file = argv[i];
+			else if (opt == "--bench")
+				bench_points = (size_t)sim::parse_number(arg);
+			else
+				usage(argv[0]);
+		}
+		if (cfg.mss <= 0)
+			throw std::invalid_argument("bad mss");
+	} catch (const std::invalid_argument &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		usage(argv[0]);
+	}
+
+	if (check_from) {
+		if (check_from >= argc)
+			usage(argv[0]);
+		check(cfg, argc, argv, check_from);
+		return 0;
+	}
+	if (bench_points) {
+		bench(cfg, bench_points, threads);
+		return 0;
+	}
+
+	/* rate, rtt, buffer and size are always columns; the others if given */
+	sim::model::batch defaults;
+	std::vector<sim::axis> grid;
+
+	defaults.resize(1);
+	for (sim::axis &a : axes) {
+		if (a.values.empty()) {
+			if (a.name == "iw" || a.name == "suss" || a.name == "suss_max")
+				continue;
+			if (a.name == "rate")
+				a.values = { defaults.rate_mbps[0] };
+			else if (a.name == "rtt")
+				a.values = { defaults.rtt_ms[0] };
+			else if (a.name == "buffer")
+				a.values = { defaults.buffer_bdp[0] };
+			else
+				a.values = { defaults.bytes[0] };
+		}
+		for (double v : a.values)
+			if (v <= 0 && a.name != "buffer" && a.name != "suss" && a.name != "suss_max") {
+				std::fprintf(stderr, "%s: bad %s\n", argv[0], a.name.c_str());
+				usage(argv[0]);
+			}
+		grid.push_back(a);
+	}
+
+	sim::model::batch in;
+	sim::model::results res;
+
+	fill_grid(grid, in);
+	sim::model::run(cfg, in, res, threads);
+
+	if (out_file && !(out = std::fopen(out_file, "w"))) {
+		std::perror(out_file);
+		return 1;
+	}
+	/* The columns of suss_sweep; retrans are the lost packets */
+	std::fprintf(out, "# %s\n#", cmd.c_str());
+	for (const sim::axis &a : grid)
+		std::fprintf(out, " %s", a.name.c_str());
+	std::fprintf(out, " fct_us ss_exit_us ss_cwnd jumps retrans lost\n");
+	for (size_t i = 0; i < in.size(); i++) {
+		for (const sim::axis &a : grid) {
+			double v = a.name == "rate" ? in.rate_mbps[i] :
+				   a.name == "rtt" ? in.rtt_ms[i] :
+				   a.name == "buffer" ? in.buffer_bdp[i] :
+				   a.name == "size" ? in.bytes[i] :
+				   a.name == "iw" ? in.iw[i] :
+				   a.name == "suss" ? in.suss[i] : in.suss_max[i];
+
+			std::fprintf(out, "%.10g ", v);
+		}
+		if (std::isnan(res.fct_us[i]))
+			std::fprintf(out, "-");
+		else
+			std::fprintf(out, "%.0f", res.fct_us[i]);
+		std::fprintf(out, " %.0f %.0f %.0f %.0f %.0f\n", res.exit_us[i], res.exit_cwnd[i],
+			     res.jumps[i], res.lost[i], res.lost[i]);
+	}
+
+	if (out != stdout)
+		std::fclose(out);
+	return 0;
+}
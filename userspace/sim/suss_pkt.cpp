@@ -0,0 +1,346 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * suss_pkt: writes a packetdrill script of a download from port 80, with the
+ * packets that the SUSS of linux-6.8 sends, as the simulator sends them.
+ *
+ *	suss_pkt --rtt 100 --rate 20 --size 100k > growth.pkt
+ *	suss_pkt --rtt 100 --rate 20 --size 100k --drop 30 > loss.pkt
+ *
+ * The remote end of the script is the client: it connects with an MSS of
+ * --mss, SACK and no timestamps at time 0, completes the handshake after
+ * --rtt, and ACKs each data segment on its own (SACK blocks for what it has
+ * out of order) when the segment has passed a FIFO bottleneck of --rate and
+ * the RTT. The bottleneck spaces the ACKs of a train; with --rate 0 there is
+ * none, the ACKs of a train arrive at once and the blue trains take 0 us. The
+ * first transmissions of the segments of --drop are lost. The server writes
+ * --size bytes at once on the accepted socket, without a FIN, so SUSS does not
+ * know the size of the flow (SIM_HINT_NONE).
+ *
+ * The script sets the module parameters of tcp_suss and tcp_cubic and the
+ * sysctls that the timing depends on, so that it does not depend on the host
+ * (see usageGuide/packetdrill/run.sh). The packets are the simulator's, which
+ * has no TSO: no script has been checked against a kernel yet. The
+ * SUSSmsg lines that the sender prints are comments at their times.
+ */
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "options.hpp"
+#include "sim.hpp"
+
+static void usage(const char *prog)
+{
+	std::fprintf(stderr,
+		"Usage: %s [options]\n"
+		"Writes a packetdrill script of a download from port 80 to stdout.\n"
+		"  --rtt MS           base RTT (100)\n"
+		"  --rate MBIT        bottleneck rate, 0 for none (20)\n"
+		"  --size N           bytes written by the server, with k or m (100k)\n"
+		"  --mss N            MSS of the client (1000)\n"
+		"  --drop LIST        comma separated segments (from 0) whose first\n"
+		"                     transmission is lost\n"
+		"  --cc NAME          cubic or reno (cubic)\n"
+		"  --time S           end the script after S seconds (10)\n"
+		"  -p NAME=VALUE      module parameter of tcp_suss or tcp_cubic, e.g., suss=0\n"
+		"                     or sysctl of the netns, e.g., tcp_cubic_hystart_plus=1\n"
+		"                     (suss=1 unless set)\n",
+		prog);
+	std::exit(2);
+}
+
+/* The module parameters of linux-6.8 that the script sets, and where */
+static const std::pair<const char *, const char *> module_params[] = {
+	{ "tcp_suss", "suss" },
+	{ "tcp_suss", "suss_max" },
+	{ "tcp_suss", "suss_max_cap" },
+	{ "tcp_suss", "suss_kmax" },
+	{ "tcp_suss", "suss_rto" },
+	{ "tcp_suss", "suss_gradient" },
+	{ "tcp_suss", "suss_rtt_win" },
+	{ "tcp_suss", "suss_stages" },
+	{ "tcp_suss", "suss_budget" },
+	{ "tcp_cubic", "fast_convergence" },
+	{ "tcp_cubic", "beta" },
+	{ "tcp_cubic", "initial_ssthresh" },
+	{ "tcp_cubic", "tcp_friendliness" },
+	{ "tcp_cubic", "hystart" },
+	{ "tcp_cubic", "hystart_detect" },
+	{ "tcp_cubic", "hystart_low_window" },
+	{ "tcp_cubic", "hystart_ack_delta_us" },
+};
+
+/* A line of the script at a time in ns */
+struct line {
+	sim::u64 t_ns;
+	std::string text;
+};
+
+static std::string at(sim::u64 t_ns)
+{
+	char buf[32];
+
+	std::snprintf(buf, sizeof(buf), "%" PRIu64 ".%06" PRIu64, t_ns / 1000000000,
+		      t_ns / 1000 % 1000000);
+	return buf;
+}
+
+int main(int argc, char **argv)
+{
+	const sim_kernel *k = &sim_kernel_6_8;
+	std::vector<std::pair<std::string, int>> params;
+	std::set<sim::u32> drops;
+	std::string cc = "cubic";
+	double rtt_ms = 100, rate_mbps = 20, time_s = 10;
+	sim::u32 mss = 1000, bytes = 100 << 10;
+	std::string cmdline;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string o = argv[i];
+
+			if (o == "-h" || o == "--help" || i + 1 >= argc)
+				usage(argv[0]);
+			std::string arg = argv[++i];
+
+			if (o == "--rtt")
+				rtt_ms = sim::parse_number(arg);
+			else if (o == "--rate")
+				rate_mbps = sim::parse_number(arg);
+			else if (o == "--size")
+				bytes = (sim::u32)sim::parse_bytes(arg);
+			else if (o == "--mss")
+				mss = (sim::u32)sim::parse_number(arg);
+			else if (o == "--drop")
+				for (double v : sim::parse_values(arg))
+					drops.insert((sim::u32)v);
+			else if (o == "--cc")
+				cc = arg;
+			else if (o == "--time")
+				time_s = sim::parse_number(arg);
+			else if (o == "-p")
+				params.push_back(sim::parse_param(sim::scenario(), arg));
+			else
+				usage(argv[0]);
+			cmdline += " " + o + " " + arg;
+		}
+	} catch (const std::invalid_argument &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		usage(argv[0]);
+	}
+	if (rtt_ms < 1 || rate_mbps < 0 || !bytes || mss < 100 || mss > 1460 ||
+	    (cc != "cubic" && cc != "reno"))
+		usage(argv[0]);
+
+	/* SUSS runs unless -p sets suss */
+	int on = 1;
+	k->param("suss", &on, 1);
+	for (const auto &p : params) {
+		int v = p.second;
+
+		k->param(p.first.c_str(), &v, 1);
+	}
+	k->load();
+
+	sim::u64 rtt_ns = (sim::u64)(rtt_ms * 1e6), end_ns = (sim::u64)(time_s * 1e9);
+	sim::u32 segs = (bytes + mss - 1) / mss;
+	std::vector<line> lines;
+	auto add = [&](sim::u64 t_ns, const std::string &text) { lines.push_back({ t_ns, text }); };
+
+	/* The SUSSmsg lines, except the one per ACK */
+	sim::u64 now = rtt_ns;
+	auto on_log = [&](const char *msg) {
+		if (std::string(msg).compare(0, 8, "SUSSmsg@"))
+			add(now, std::string("// ") + msg);
+	};
+	k->log([](void *ctx, const char *msg) {
+		(*static_cast<decltype(on_log) *>(ctx))(msg);
+	}, &on_log);
+
+	/* The client: arrivals of segments (time, segment) in the order of the
+	 * bottleneck, what it has received and the transmissions so far */
+	using arrival = std::pair<sim::u64, sim::u32>;
+	std::priority_queue<arrival, std::vector<arrival>, std::greater<arrival>> arrivals;
+	std::vector<bool> received(segs);
+	std::vector<sim::u32> sent(segs);
+	sim::u64 link_free = 0;
+	sim::u32 cum = 0;
+
+	auto on_emit = [&](const sim_seg *seg) {
+		char buf[128];
+		sim::u32 seq = seg->idx * mss + 1;
+		bool last = seg->idx + 1 == segs;
+
+		std::snprintf(buf, sizeof(buf), "> %s %u:%u(%u) ack 1", last ? "P." : ".",
+			      seq, seq + seg->len, seg->len);
+		add(seg->time_ns, buf);
+		if (sent[seg->idx]++ == 0 && drops.count(seg->idx))
+			return;
+
+		/* Serialization at the bottleneck (with the IP and TCP headers),
+		 * then the RTT */
+		link_free = std::max(link_free, seg->time_ns);
+		if (rate_mbps > 0)
+			link_free += (sim::u64)((seg->len + 40) * 8e3 / rate_mbps);
+		arrivals.push({ link_free + rtt_ns, seg->idx });
+	};
+	auto emit = [](void *ctx, const sim_seg *seg) {
+		(*static_cast<decltype(on_emit) *>(ctx))(seg);
+	};
+
+	/* The ACK of the client for an arrival: its cumulative ACK and up to
+	 * three SACK blocks, the one of the segment first */
+	auto ack_line = [&](sim::u32 idx) {
+		std::vector<std::pair<sim::u32, sim::u32>> blocks;
+		std::string text;
+		char buf[96];
+
+		if (idx > cum) {
+			sim::u32 lo = idx, hi = idx + 1;
+
+			while (lo > cum && received[lo - 1])
+				lo--;
+			while (hi < segs && received[hi])
+				hi++;
+			blocks.push_back({ lo, hi });
+			for (sim::u32 i = segs; i > cum && blocks.size() < 3; i--) {
+				if (!received[i - 1] || (i - 1 >= lo && i - 1 < hi))
+					continue;
+				sim::u32 b = i;
+
+				while (i - 1 > cum && received[i - 2])
+					i--;
+				blocks.push_back({ i - 1, b });
+			}
+		}
+		std::snprintf(buf, sizeof(buf), "< . 1:1(0) ack %u win 65535",
+			      std::min(cum * mss, bytes) + 1);
+		text = buf;
+		for (size_t i = 0; i < blocks.size(); i++) {
+			std::snprintf(buf, sizeof(buf), "%s%u:%u", i ? " " : " <sack ",
+				      blocks[i].first * mss + 1,
+				      std::min(blocks[i].second * mss, bytes) + 1);
+			text += buf;
+		}
+		if (!blocks.empty())
+			text += ",nop,nop>";
+		return text;
+	};
+
+	/* The connection, with the RTT of the handshake, at the ACK of the client */
+	sim_conn conn = {};
+	conn.cc = cc.c_str();
+	conn.mss = mss;
+	conn.bytes = bytes;
+	conn.rwnd = 65535U << 7;
+	conn.syn_rtt_us = (sim::u32)(rtt_ns / 1000);
+	conn.daddr = 0x0a000002;
+	conn.sport = 20480;
+	conn.dport = 0x1000;
+	conn.size_hint = SIM_HINT_NONE;
+	sim_sock *s = k->connect(&conn, rtt_ns);
+	if (!s) {
+		std::fprintf(stderr, "%s: the kernel has no congestion control %s\n", argv[0],
+			     cc.c_str());
+		return 2;
+	}
+	add(rtt_ns, "< . 1:1(0) ack 1 win 65535");
+	add(rtt_ns, "accept(3, ..., ...) = 4");
+	add(rtt_ns, "write(4, ..., " + std::to_string(bytes) + ") = " + std::to_string(bytes));
+	sim::u64 pace_at = k->write_xmit(s, rtt_ns, emit, &on_emit);
+
+	/* Events in time order: the pacing timer, the RTO and the ACKs */
+	while (cum < segs) {
+		sim::u64 rto = k->rto_time(s);
+		sim::u64 t = std::min(pace_at ? pace_at : UINT64_MAX, rto ? rto : UINT64_MAX);
+
+		if (!arrivals.empty() && arrivals.top().first <= t) {
+			sim::u32 idx = arrivals.top().second;
+
+			now = arrivals.top().first;
+			arrivals.pop();
+			if (now > end_ns)
+				break;
+			received[idx] = true;
+			while (cum < segs && received[cum])
+				cum++;
+
+			sim_ack ack = { cum, idx >= cum ? idx : UINT32_MAX, 0 };
+			add(now, ack_line(idx));
+			k->ack(s, now, &ack);
+			pace_at = k->write_xmit(s, now, emit, &on_emit);
+			continue;
+		}
+		if (t == UINT64_MAX || t > end_ns)
+			break;
+		now = t;
+		if (rto && rto == t)
+			k->rto(s, t);
+		pace_at = k->write_xmit(s, t, emit, &on_emit);
+	}
+
+	sim_info info;
+	k->info(s, &info);
+	k->close(s);
+	k->log(nullptr, nullptr);
+
+	/* The script: the settings, the handshake and the lines in time order;
+	 * the sender prints before it sends at the same time */
+	std::printf("// Generated by userspace/sim/suss_pkt%s\n", cmdline.c_str());
+	std::printf("// RTT %g ms, bottleneck %g Mbit/s, %u bytes in segments of %u bytes",
+		    rtt_ms, rate_mbps, bytes, mss);
+	if (!drops.empty()) {
+		const char *sep = ", lost:";
+
+		for (sim::u32 d : drops) {
+			std::printf("%s %u", sep, d);
+			sep = ",";
+		}
+	}
+	std::printf("\n// End: %u segments acked, cwnd %u, %u retransmitted\n\n",
+		    info.acked, info.cwnd, info.retrans);
+
+	std::printf("// Segments of one MSS on the wire, sent one by one when paced, and no\n"
+		    "// state from other connections\n");
+	int hystart_plus;
+	k->param("tcp_cubic_hystart_plus", &hystart_plus, 0);
+	std::printf("0 `ethtool -K tun0 tso off gso off > /dev/null 2>&1; "
+		    "sysctl -q net.ipv4.tcp_congestion_control=%s net.ipv4.tcp_min_tso_segs=1 "
+		    "net.ipv4.tcp_no_metrics_save=1 net.ipv4.tcp_wmem=\"4096 4194304 16777216\" "
+		    "net.ipv4.tcp_cubic_hystart_plus=%d`\n",
+		    cc.c_str(), hystart_plus);
+	std::string cmd;
+	for (const auto &p : module_params) {
+		int v;
+
+		if (k->param(p.second, &v, 0))
+			continue;
+		cmd += (cmd.empty() ? "" : "; ") + std::string("echo ") + std::to_string(v) +
+		       " > /sys/module/" + p.first + "/parameters/" + p.second;
+	}
+	std::printf("+0 `%s`\n\n", cmd.c_str());
+	std::printf("+0 socket(..., SOCK_STREAM, IPPROTO_TCP) = 3\n"
+		    "+0 setsockopt(3, SOL_SOCKET, SO_REUSEADDR, [1], 4) = 0\n"
+		    "+0 bind(3, ..., ...) = 0\n"
+		    "+0 listen(3, 1) = 0\n\n"
+		    "0 < S 0:0(0) win 65535 <mss %u,sackOK,nop,nop,nop,wscale 7>\n"
+		    "0 > S. 0:0(0) ack 1 <...>\n", mss);
+
+	std::stable_sort(lines.begin(), lines.end(),
+			 [](const line &a, const line &b) { return a.t_ns < b.t_ns; });
+	sim::u64 prev = UINT64_MAX;
+	for (const line &l : lines) {
+		if (l.text[0] != '/')
+			std::printf("%s %s\n", at(l.t_ns).c_str(), l.text.c_str());
+		else
+			std::printf("%s%s\n", l.t_ns != prev ? "\n" : "", l.text.c_str());
+		prev = l.t_ns;
+	}
+	return 0;
+}
@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * suss_replay: replays the flows of kern.log files through the SUSS code of
+ * the simulator and checks that it decides as the recorded kernel did.
+ *
+ *	suss_replay ../usageGuide/example/raw.suss1
+ *	suss_replay -v raw.suss1
+ *	suss_replay --tree linux-5.19.10 ../usageGuide/example/raw.suss?
+ *
+ * See replay.hpp and userspace/README.md.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "options.hpp"
+#include "replay.hpp"
+#include "sweep.hpp"
+
+static void usage(const char *prog)
+{
+	std::fprintf(stderr,
+		"Usage: %s [options] FILE...\n"
+		"Replays every flow of the SUSSmsg lines of the files (kern.log or suss_sim -r).\n"
+		"  --id N             only the flow with this id\n"
+		"  --tree NAME        kernel code to replay through: linux-6.8 or\n"
+		"                     linux-5.19.10, the one of the recording (linux-6.8)\n"
+		"  --cc NAME          cubic or reno (cubic)\n"
+		"  --mss N            (from the first ACK line)\n"
+		"  --tol F            relative tolerance of the compared values (0.05)\n"
+		"  -p NAME=VALUE      module parameter of tcp_suss or tcp_cubic, e.g., suss_max=2\n"
+		"                     or sysctl of the netns, e.g., tcp_cubic_hystart_plus=1\n"
+		"  -v                 print the decisions of the recording and the replay\n"
+		"  -j N               threads (one per core, at most %u)\n"
+		"Exits with 1 if a flow is replayed differently.\n",
+		prog, sim_kernel_6_8_nslots);
+	std::exit(2);
+}
+
+struct job {
+	const char *file;
+	sim::replay::trace rec;
+	sim::replay::trace out;
+	sim::replay::diff d;
+	sim::u32 unsent = 0;
+};
+
+/* One line per flow, and with -v the decisions side by side */
+static void report(const job &j, double tol, bool verbose)
+{
+	using namespace sim::replay;
+	const trace &rec = j.rec, &out = j.out;
+	const diff &d = j.d;
+
+	std::printf("%s id=%u acks=%zu decisions=%zu/%zu", j.file, rec.id, rec.acks.size(),
+		    d.matched, rec.decisions.size());
+	if (d.ok()) {
+		std::printf(" same\n");
+	} else {
+		if (d.decision != SIZE_MAX) {
+			std::string a = d.decision < rec.decisions.size() ?
+					describe(rec.decisions[d.decision]) : "-";
+			std::string b = d.decision < out.decisions.size() ?
+					describe(out.decisions[d.decision]) : "-";
+			const trace &at = d.decision < rec.decisions.size() ? rec : out;
+			const decision &x = d.decision < rec.decisions.size() ?
+					    rec.decisions[d.decision] : out.decisions[d.decision];
+
+			std::printf(" first=%.1fms recorded=\"%s\" replayed=\"%s\"",
+				    at.time_us(x) / 1e3, a.c_str(), b.c_str());
+		}
+		if (d.ack != SIZE_MAX) {
+			const ack_line &a = rec.acks[d.ack];
+
+			std::printf(" ack=%zu at %.1fms", d.ack, (a.t_us - rec.acks[0].t_us) / 1e3);
+			for (const ack_line &b : out.acks)
+				if (b.t_us == a.t_us) {
+					std::printf(" c=%u/%u s=%u/%u Rnd=%u/%u", a.cwnd, b.cwnd,
+						    a.state, b.state, a.round, b.round);
+					break;
+				}
+		}
+		if (d.unpaired)
+			std::printf(" unpaired=%zu", d.unpaired);
+		if (j.unsent)
+			std::printf(" unsent=%u", j.unsent);
+		std::printf("\n");
+	}
+	if (verbose)
+		print_decisions(stdout, rec, out, tol, "recorded", "replayed");
+}
+
+int main(int argc, char **argv)
+{
+	sim::replay::options opt;
+	std::vector<const char *> files;
+	double tol = 0.05;
+	long long only = -1;
+	unsigned threads = 0;
+	bool verbose = false;
+	const sim_kernel *const *slots = sim_kernel_6_8_slots;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string o = argv[i];
+
+			if (o == "-h" || o == "--help")
+				usage(argv[0]);
+			if (o == "-v") {
+				verbose = true;
+				continue;
+			}
+			if (o[0] != '-') {
+				files.push_back(argv[i]);
+				continue;
+			}
+			if (i + 1 >= argc)
+				usage(argv[0]);
+			std::string arg = argv[++i];
+
+			if (o == "--id")
+				only = (long long)sim::parse_number(arg);
+			else if (o == "--tree" && arg == sim_kernel_6_8.tree)
+				slots = sim_kernel_6_8_slots;
+			else if (o == "--tree" && arg == sim_kernel_5_19.tree)
+				slots = sim_kernel_5_19_slots;
+			else if (o == "--cc")
+				opt.cc = arg;
+			else if (o == "--mss")
+				opt.mss = (sim::u32)sim::parse_number(arg);
+			else if (o == "--tol")
+				tol = sim::parse_number(arg);
+			else if (o == "-p")
+				opt.params.push_back(sim::parse_param(sim::scenario(), arg));
+			else if (o == "-j")
+				threads = (unsigned)sim::parse_number(arg);
+			else
+				usage(argv[0]);
+		}
+	} catch (const std::invalid_argument &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		usage(argv[0]);
+	}
+	if (files.empty())
+		usage(argv[0]);
+
+	std::vector<job> jobs;
+	for (const char *f : files) {
+		std::ifstream in(f);
+
+		if (!in) {
+			std::perror(f);
+			return 2;
+		}
+		for (sim::replay::trace &tr : sim::replay::read_log(in)) {
+			if (only >= 0 && tr.id != (sim::u32)only)
+				continue;
+			jobs.emplace_back();
+			jobs.back().file = f;
+			jobs.back().rec = std::move(tr);
+		}
+	}
+
+	/* Each thread replays on its own copy of the kernel code, as in a sweep */
+	if (!threads)
+		threads = std::max(1U, std::thread::hardware_concurrency());
+	threads = (unsigned)std::min<sim::u64>({ threads, sim_kernel_6_8_nslots,
+						 std::max<size_t>(jobs.size(), 1) });
+	sim::work_queues queues(threads, jobs.size());
+	std::vector<std::thread> workers;
+
+	for (unsigned t = 0; t < threads; t++)
+		workers.emplace_back([&, t] {
+			const sim_kernel *k = slots[t];
+			sim::u64 i;
+
+			while (queues.take(t, i)) {
+				job &j = jobs[i];
+
+				j.out = sim::replay::run(k, j.rec, opt, &j.unsent);
+				j.d = sim::replay::compare(j.rec, j.out, tol);
+			}
+		});
+	for (std::thread &w : workers)
+		w.join();
+
+	int ret = 0;
+	for (const job &j : jobs) {
+		report(j, tol, verbose);
+		if (!j.d.ok())
+			ret = 1;
+	}
+	return ret;
+}
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * suss_sim: runs one scenario of sim.hpp and prints a line per flow.
+ *
+ *	suss_sim --rate 100 --rtt 50 --size 16m -p suss=1 -d data.suss1 -r raw.suss1
+ *
+ * See userspace/README.md.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "options.hpp"
+
+static void usage(const char *prog)
+{
+	std::fprintf(stderr,
+		"Usage: %s [options]\n"
+		"%s"
+		"  -p NAME=VALUE      module parameter of tcp_suss or tcp_cubic, e.g., suss=1\n"
+		"                     or sysctl of the netns, e.g., tcp_cubic_hystart_plus=1\n"
+		"  -d FILE            SUSSmsg@ lines of flow 0 in the format of data.suss\n"
+		"  -r FILE            every SUSSmsg line, as in kern.log (see extract.sh)\n",
+		prog, sim::option_help);
+	std::exit(1);
+}
+
+/* A SUSSmsg@ line as extract.sh makes it: from "id=" on, '=' as ' ', and t
+ * relative to the first line */
+static void data_line(std::FILE *f, const char *msg, bool &first, unsigned long long &base)
+{
+	const char *p = std::strstr(msg, "SUSSmsg@ id=");
+	std::string line;
+	char *tok, *save;
+	int n = 0;
+
+	if (!p)
+		return;
+	line = p + std::strlen("SUSSmsg@ ");
+	for (char &c : line)
+		if (c == '=')
+			c = ' ';
+	for (tok = strtok_r(&line[0], " \t", &save); tok; tok = strtok_r(nullptr, " \t", &save)) {
+		if (++n == 4) {
+			unsigned long long t = std::strtoull(tok, nullptr, 10);
+
+			if (first) {
+				base = t;
+				first = false;
+			}
+			std::fprintf(f, " %llu", t - base);
+			continue;
+		}
+		std::fprintf(f, n == 1 ? "%s" : " %s", tok);
+	}
+	std::fputc('\n', f);
+}
+
+int main(int argc, char **argv)
+{
+	sim::scenario sc;
+	const char *data_file = nullptr, *raw_file = nullptr;
+	std::FILE *data = nullptr, *raw = nullptr;
+	bool first = true;
+	unsigned long long base = 0;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string opt = argv[i];
+
+			if (opt == "-h" || opt == "--help" || i + 1 >= argc)
+				usage(argv[0]);
+			std::string arg = argv[++i];
+
+			if (sim::parse_option(sc, opt, arg))
+				continue;
+			if (opt == "-p")
+				sc.params.push_back(sim::parse_param(sc, arg));
+			else if (opt == "-d")
+				data_file = argv[i];
+			else if (opt == "-r")
+				raw_file = argv[i];
+			else
+				usage(argv[0]);
+		}
+		sim::check_scenario(sc);
+	} catch (const std::invalid_argument &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		usage(argv[0]);
+	}
+
+	if (data_file && !(data = std::fopen(data_file, "w"))) {
+		std::perror(data_file);
+		return 1;
+	}
+	if (raw_file && !(raw = std::fopen(raw_file, "w"))) {
+		std::perror(raw_file);
+		return 1;
+	}
+
+	sim::log_fn log;
+	if (data || raw)
+		log = [&](sim::u32 flow, sim::u64 now_ns, const char *msg) {
+			if (raw)
+				std::fprintf(raw, "sim kernel: [%12.6f] %s\n", now_ns / 1e9, msg);
+			if (data && flow == 0)
+				data_line(data, msg, first, base);
+		};
+
+	for (const sim::flow_result &r : sim::run(sc, log)) {
+		std::printf("flow=%u id=%u bytes=%llu", r.flow, r.id, (unsigned long long)r.bytes);
+		if (r.done)
+			std::printf(" fct_us=%llu", (unsigned long long)r.fct_us);
+		else
+			std::printf(" fct_us=-");
+		std::printf(" ss_exit_us=%llu ss_cwnd=%u jumps=%u retrans=%u lost=%u\n",
+			    (unsigned long long)r.ss_exit_us, r.ss_cwnd, r.jumps, r.retrans, r.lost);
+	}
+
+	if (data)
+		std::fclose(data);
+	if (raw)
+		std::fclose(raw);
+	return 0;
+}
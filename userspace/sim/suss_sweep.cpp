@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * suss_sweep: runs the scenarios of a grid on all cores and writes one table,
+ * a row per point.
+ *
+ *	suss_sweep --rate 10:100000:x10 --rtt 10,50,200 --buffer 0.1,1,2 \
+ *		   --size 1m,16m -p suss=0,1 -p suss_max=1:3:+1 -o sweep.tsv
+ *
+ * See userspace/README.md.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+
+#include "options.hpp"
+#include "sweep.hpp"
+
+static void usage(const char *prog)
+{
+	std::fprintf(stderr,
+		"Usage: %s [options]\n"
+		"The options --rate, --rtt, --buffer (in BDPs), --size, --loss and --ecn, and\n"
+		"the module parameters take lists of values: a,b,c or lo:hi:xF (geometric)\n"
+		"or lo:hi:+S (arithmetic). The grid is all their combinations.\n"
+		"%s"
+		"  -p NAME=LIST       module parameter of tcp_suss or tcp_cubic, e.g., suss=0,1\n"
+		"                     or sysctl of the netns, e.g., tcp_cubic_hystart_plus=0,1\n"
+		"  -j N               threads (one per core, at most %u)\n"
+		"  -o FILE            the table (stdout)\n",
+		prog, sim::option_help, sim_kernel_6_8_nslots);
+	std::exit(1);
+}
+
+static const char *const axis_options[] = {
+	"--rate", "--rtt", "--buffer", "--size", "--loss", "--ecn",
+};
+
+int main(int argc, char **argv)
+{
+	sim::sweep sw;
+	std::vector<sim::axis> axes(std::size(axis_options));
+	std::vector<sim::axis> params;
+	unsigned threads = 0;
+	const char *out_file = nullptr;
+	std::FILE *out = stdout;
+	std::string cmd = "suss_sweep";
+
+	for (size_t k = 0; k < axes.size(); k++)
+		axes[k].name = axis_options[k] + 2;
+
+	try {
+		for (int i = 1; i < argc; i++) {
+			std::string opt = argv[i];
+			bool axis = false;
+
+			if (opt == "-h" || opt == "--help" || i + 1 >= argc)
+				usage(argv[0]);
+			std::string arg = argv[++i];
+			cmd += " " + opt + " " + arg;
+
+			for (size_t k = 0; k < axes.size(); k++) {
+				if (opt != axis_options[k])
+					continue;
+				if (axes[k].name == "size")
+					axes[k].values = sim::parse_values(arg, sim::parse_bytes);
+				else
+					axes[k].values = sim::parse_values(arg);
+				axis = true;
+			}
+			if (axis || sim::parse_option(sw.base, opt, arg))
+				continue;
+			if (opt == "-p") {
+				size_t eq = arg.find('=');
+				sim::axis a;
+
+				sim::parse_param(sw.base, arg.substr(0, eq) + "=0");
+				a.name = arg.substr(0, eq);
+				a.values = sim::parse_values(arg.substr(eq + 1));
+				params.push_back(a);
+			} else if (opt == "-j") {
+				threads = (unsigned)sim::parse_number(arg);
+			} else if (opt == "-o") {
+				out_file = argv[i];
+			} else {
+				usage(argv[0]);
+			}
+		}
+	} catch (const std::invalid_argument &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		usage(argv[0]);
+	}
+
+	/* rate, rtt, buffer and size are always columns; loss and ecn if given */
+	for (sim::axis &a : axes) {
+		if (a.values.empty()) {
+			if (a.name == "loss" || a.name == "ecn")
+				continue;
+			if (a.name == "rate")
+				a.values = { sw.base.rate_mbps };
+			else if (a.name == "rtt")
+				a.values = { sw.base.rtt_ms };
+			else if (a.name == "buffer")
+				a.values = { sw.base.buffer_bdp };
+			else
+				a.values = { (double)sw.base.bytes };
+		}
+		sw.axes.push_back(a);
+	}
+	sw.axes.insert(sw.axes.end(), params.begin(), params.end());
+
+	try {
+		for (sim::u64 i = 0; i < sw.points(); i++) {
+			std::vector<double> values;
+
+			sim::check_scenario(sw.point(i, values));
+		}
+	} catch (const std::invalid_argument &e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		usage(argv[0]);
+	}
+
+	if (out_file && !(out = std::fopen(out_file, "w"))) {
+		std::perror(out_file);
+		return 1;
+	}
+
+	sim::progress_fn progress;
+	if (isatty(STDERR_FILENO))
+		progress = [](sim::u64 done, sim::u64 total) {
+			std::fprintf(stderr, "\r%llu/%llu", (unsigned long long)done,
+				     (unsigned long long)total);
+		};
+	std::vector<sim::sweep_result> res = sim::run_sweep(sw, threads, progress);
+	if (progress)
+		std::fprintf(stderr, "\r");
+
+	/* fct_us, ss_exit_us and ss_cwnd are the means over the flows, jumps,
+	 * retrans and lost the sums; fct_us is "-" if a flow did not end. */
+	std::fprintf(out, "# %s\n#", cmd.c_str());
+	for (const sim::axis &a : sw.axes)
+		std::fprintf(out, " %s", a.name.c_str());
+	std::fprintf(out, " fct_us ss_exit_us ss_cwnd jumps retrans lost\n");
+	for (const sim::sweep_result &r : res) {
+		double fct = 0, exit = 0, cwnd = 0;
+		unsigned long long jumps = 0, retrans = 0, lost = 0;
+		bool done = true;
+
+		for (double v : r.values)
+			std::fprintf(out, "%.10g ", v);
+		for (const sim::flow_result &f : r.flows) {
+			done &= f.done;
+			fct += f.fct_us;
+			exit += f.ss_exit_us;
+			cwnd += f.ss_cwnd;
+			jumps += f.jumps;
+			retrans += f.retrans;
+			lost += f.lost;
+		}
+		if (done)
+			std::fprintf(out, "%.0f", fct / r.flows.size());
+		else
+			std::fprintf(out, "-");
+		std::fprintf(out, " %.0f %.0f %llu %llu %llu\n", exit / r.flows.size(),
+			     cwnd / r.flows.size(), jumps, retrans, lost);
+	}
+
+	if (out != stdout)
+		std::fclose(out);
+	return 0;
+}
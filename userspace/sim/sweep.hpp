@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Parameter sweeps of sim.hpp: the scenarios of a grid, run on all cores.
+ *
+ *	sim::sweep sw;
+ *	sw.axes = { { "rate", { 10, 100, 1000 } }, { "suss", { 0, 1 } } };
+ *	std::vector<sim::sweep_result> res = sim::run_sweep(sw, 8);
+ *
+ * Each thread runs its scenarios on its own copy of the kernel code (see
+ * sim_slot.h), so the number of threads is at most sim_kernel_6_8_nslots.
+ * The points are dealt round robin to the threads, and a thread that runs out
+ * steals from the back of the others, so the long scenarios (large flows on
+ * slow links) do not leave cores idle. A point's result does not depend on
+ * the thread that ran it.
+ */
+#ifndef SIM_SWEEP_HPP
+#define SIM_SWEEP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sim.hpp"
+
+namespace sim {
+
+/* A dimension of the grid: "rate" (Mbit/s), "rtt" (ms), "buffer" (BDPs),
+ * "size" (bytes), "loss", "ecn" (BDPs) or a module parameter */
+struct axis {
+	std::string name;
+	std::vector<double> values;
+};
+
+struct sweep {
+	scenario base;
+	std::vector<axis> axes;		/* the last one varies fastest */
+
+	u64 points() const
+	{
+		u64 n = 1;
+
+		for (const axis &a : axes)
+			n *= a.values.size();
+		return n;
+	}
+
+	/* The scenario of point i, and its values on the axes */
+	scenario point(u64 i, std::vector<double> &values) const
+	{
+		scenario sc = base;
+
+		values.assign(axes.size(), 0);
+		for (size_t k = axes.size(); k-- > 0;) {
+			const axis &a = axes[k];
+			double v = a.values[i % a.values.size()];
+
+			i /= a.values.size();
+			values[k] = v;
+			if (a.name == "rate") {
+				sc.rate_mbps = v;
+			} else if (a.name == "rtt") {
+				sc.rtt_ms = v;
+			} else if (a.name == "buffer") {
+				sc.buffer_bdp = v;
+				sc.buffer_bytes = 0;
+			} else if (a.name == "size") {
+				sc.bytes = (u64)v;
+			} else if (a.name == "loss") {
+				sc.loss = v;
+			} else if (a.name == "ecn") {
+				sc.ecn_bdp = v;
+			} else {
+				sc.params.emplace_back(a.name, (int)v);
+			}
+		}
+		return sc;
+	}
+};
+
+struct sweep_result {
+	std::vector<double> values;	/* of the point on the axes */
+	std::vector<flow_result> flows;
+};
+
+/* Deques of point indices, one per thread */
+class work_queues {
+public:
+	work_queues(unsigned threads, u64 points) : q_(threads)
+	{
+		for (u64 i = 0; i < points; i++)
+			q_[i % threads].items.push_back(i);
+	}
+
+	/* The next point for thread t, from its own front or the back of
+	 * another. False when all are taken. */
+	bool take(unsigned t, u64 &i)
+	{
+		if (q_[t].pop(i, true))
+			return true;
+		for (size_t k = 1; k < q_.size(); k++)
+			if (q_[(t + k) % q_.size()].pop(i, false))
+				return true;
+		return false;
+	}
+
+private:
+	struct queue {
+		std::mutex lock;
+		std::deque<u64> items;
+
+		bool pop(u64 &i, bool front)
+		{
+			std::lock_guard<std::mutex> g(lock);
+
+			if (items.empty())
+				return false;
+			if (front) {
+				i = items.front();
+				items.pop_front();
+			} else {
+				i = items.back();
+				items.pop_back();
+			}
+			return true;
+		}
+	};
+
+	std::vector<queue> q_;
+};
+
+/* Gets the number of points done so far, about once a second */
+using progress_fn = std::function<void(u64 done, u64 total)>;
+
+/* Runs every point of the sweep on `threads` threads (0: one per core) */
+inline std::vector<sweep_result> run_sweep(const sweep &sw, unsigned threads,
+					   progress_fn progress = {})
+{
+	u64 total = sw.points();
+	std::vector<sweep_result> res(total);
+	std::atomic<u64> done(0);
+	std::mutex lock;
+	std::condition_variable cv;
+	std::vector<std::thread> workers;
+
+	if (!threads)
+		threads = std::max(1U, std::thread::hardware_concurrency());
+	threads = (unsigned)std::min<u64>({ threads, sim_kernel_6_8_nslots, std::max<u64>(total, 1) });
+	work_queues queues(threads, total);
+
+	for (unsigned t = 0; t < threads; t++)
+		workers.emplace_back([&, t] {
+			u64 i;
+
+			while (queues.take(t, i)) {
+				scenario sc = sw.point(i, res[i].values);
+
+				sc.kernel = sim_kernel_6_8_slots[t];
+				res[i].flows = run(sc);
+				if (++done == total) {
+					std::lock_guard<std::mutex> g(lock);
+					cv.notify_all();
+				}
+			}
+		});
+
+	{
+		std::unique_lock<std::mutex> g(lock);
+
+		while (!cv.wait_for(g, std::chrono::seconds(1), [&] { return done == total; }))
+			if (progress)
+				progress(done, total);
+	}
+	for (std::thread &w : workers)
+		w.join();
+	return res;
+}
+
+} /* namespace sim */
+
+#endif /* SIM_SWEEP_HPP */
@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * A bottleneck that follows a packet delivery trace in the format of
+ * Mahimahi's mm-link (the .up and .down files of its traces/): one line per
+ * delivery opportunity, the time in ms at which one MTU can leave. Several
+ * lines with the same time are several opportunities. The trace repeats, with
+ * the time of its last line as the period.
+ *
+ *	sc.make_link = [](const sim::scenario &sc) {
+ *		return std::make_unique<sim::trace_link>("Verizon-LTE-driving.down",
+ *							 sc.buffer(), sc.loss, 0, sc.seed);
+ *	};
+ *
+ * As in mm-link, an opportunity carries MTU bytes of the queue, and a packet
+ * leaves at the opportunity that carries its last byte. The bytes of an
+ * opportunity that finds the queue empty are lost. The trace starts with the
+ * first packet. The file is read as the link advances, so a trace of hours
+ * takes no memory.
+ */
+#ifndef SIM_TRACE_LINK_HPP
+#define SIM_TRACE_LINK_HPP
+
+#include <cerrno>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "sim.hpp"
+
+namespace sim {
+
+class trace_link : public link {
+public:
+	/* Bytes per opportunity: one full sized segment, mss + HEADER_BYTES */
+	static constexpr u32 MTU = 1500;
+
+	trace_link(const std::string &path, u64 buffer_bytes, double loss, u64 ecn_bytes, u64 seed)
+		: path_(path), in_(path), buffer_(buffer_bytes), ecn_(ecn_bytes), loss_(loss),
+		  rng_(seed)
+	{
+		if (!in_)
+			throw std::invalid_argument("cannot read " + path);
+	}
+
+	bool enqueue(u64 now_ns, u32 bytes, u64 &depart_ns, bool &ce) override
+	{
+		while (!queue_.empty() && queue_.front().first <= now_ns) {
+			backlog_ -= queue_.front().second;
+			queue_.pop_front();
+		}
+		if (backlog_ + bytes > buffer_)
+			return false;
+		if (loss_ > 0 && std::uniform_real_distribution<double>(0, 1)(rng_) < loss_)
+			return false;
+		ce = ecn_ && backlog_ >= ecn_;
+
+		if (!started_) {
+			started_ = true;
+			origin_ns_ = now_ns;
+		}
+		/* An empty queue wastes the rest of the current opportunity and
+		 * those that passed */
+		if (queue_.empty() && (left_ < MTU || op_ns_ < now_ns)) {
+			do
+				next();
+			while (op_ns_ < now_ns);
+		}
+		for (u32 need = bytes;;) {
+			if (need <= left_) {
+				left_ -= need;
+				break;
+			}
+			need -= left_;
+			next();
+		}
+
+		depart_ns = op_ns_;
+		queue_.emplace_back(op_ns_, bytes);
+		backlog_ += bytes;
+		return true;
+	}
+
+	/* Checks the trace at path and returns its mean rate in bit/s */
+	static double mean_rate(const std::string &path)
+	{
+		std::ifstream in(path);
+		u64 n = 0, ms = 0, lineno = 0;
+
+		if (!in)
+			throw std::invalid_argument("cannot read " + path);
+		while (read_line(in, path, lineno, ms))
+			n++;
+		if (!n || !ms)
+			throw std::invalid_argument(path + ": needs lines and a last time above 0");
+		return n * MTU * 8e3 / ms;
+	}
+
+private:
+	/* Reads the time of the next line into ms; false at the end of the file */
+	static bool read_line(std::ifstream &in, const std::string &path, u64 &lineno, u64 &ms)
+	{
+		std::string line;
+
+		while (std::getline(in, line)) {
+			const char *s = line.c_str();
+			char *end;
+			unsigned long long v;
+
+			lineno++;
+			if (line.find_first_not_of(" \t\r") == std::string::npos)
+				continue;
+			errno = 0;
+			v = std::strtoull(s, &end, 10);
+			while (*end == ' ' || *end == '\t' || *end == '\r')
+				end++;
+			if (errno || end == s || *end || v < ms)
+				throw std::invalid_argument(path + ":" + std::to_string(lineno) +
+							    ": not an increasing time in ms");
+			ms = v;
+			return true;
+		}
+		return false;
+	}
+
+	/* Moves to the next opportunity, from the file or its next repetition */
+	void next()
+	{
+		u64 ms = last_ms_;
+
+		if (!read_line(in_, path_, lineno_, ms)) {
+			if (!last_ms_)
+				throw std::invalid_argument(path_ + ": needs lines and a last time above 0");
+			base_ms_ += last_ms_;
+			in_.clear();
+			in_.seekg(0);
+			lineno_ = 0;
+			ms = 0;
+			if (!read_line(in_, path_, lineno_, ms))
+				throw std::invalid_argument(path_ + ": changed while read");
+		}
+		last_ms_ = ms;
+		op_ns_ = origin_ns_ + (base_ms_ + ms) * NSEC_PER_MSEC;
+		left_ = MTU;
+	}
+
+	std::string path_;
+	std::ifstream in_;
+	u64 lineno_ = 0;
+	u64 base_ms_ = 0;	/* start of the current repetition of the trace */
+	u64 last_ms_ = 0;	/* time of the last line read */
+	bool started_ = false;
+	u64 origin_ns_ = 0;	/* time 0 of the trace */
+	u64 op_ns_ = 0;		/* the current opportunity ... */
+	u32 left_ = 0;		/* ... and its bytes not used yet */
+
+	std::deque<std::pair<u64, u32>> queue_;	/* departure and size */
+	u64 backlog_ = 0;
+	u64 buffer_;
+	u64 ecn_;		/* CE threshold of the backlog, 0 if no ECN */
+	double loss_;		/* random loss, before the queue */
+	std::mt19937_64 rng_;
+};
+
+} /* namespace sim */
+
+#endif /* SIM_TRACE_LINK_HPP */
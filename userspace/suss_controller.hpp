@@ -0,0 +1,664 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * SUSS slow start for user-space transports (e.g., QUIC).
+ *
+ * This is the per-flow part of sourceCode/linux-6.8/suss/tcp_suss.c (round
+ * tracking, blue/red classification, suss_speedup, the pacing plan and its
+ * stages and feedback, suss_cap, ECE), written with the same integer
+ * arithmetic: the widths of the kernel's bit fields, the x86 semantics of its
+ * shifts and its guards against divisions by zero are kept. sim/suss_lockstep
+ * gives it and the kernel code of the simulator the same flows and checks that
+ * they decide the same on every packet sent and every ACK.
+ * The parts that are shared between flows (per destination table, netns
+ * budget) and the recovery after an RTO stay in the kernel.
+ *
+ * Header only, no allocation, no locking: one controller per connection.
+ *
+ *	suss::controller cc(cfg);
+ *	cc.start(now_ns, 0, handshake_rtt_us);
+ *	... on each packet sent:    cc.on_packet_sent(now_ns, segs, inflight);
+ *	... on each ACK:            cc.on_ack(sample);
+ *	... on loss or ECN CWR:     cc.on_loss(inflight);
+ *	while cc.in_slow_start(), send with cc.cwnd() and, if cc.pacing_rate()
+ *	is not 0, pace at that rate from cc.pacing_start_ns() on.
+ *
+ * Sequence numbers are byte offsets from the start of the connection (mod
+ * 2^32), e.g., the offset of the largest acknowledged byte in QUIC.
+ */
+#ifndef SUSS_CONTROLLER_HPP
+#define SUSS_CONTROLLER_HPP
+
+#include <algorithm>
+#include <cstdint>
+
+namespace suss {
+
+using u8 = std::uint8_t;
+using u16 = std::uint16_t;
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+using s32 = std::int32_t;
+using s64 = std::int64_t;
+
+/* Windowed min filter of lib/win_minmax.c (Kathleen Nichols' algorithm) */
+struct minmax {
+	struct sample {
+		u32 t;
+		u32 v;
+	} s[3];
+
+	u32 get() const { return s[0].v; }
+
+	u32 reset(u32 t, u32 meas)
+	{
+		s[2] = s[1] = s[0] = { t, meas };
+		return s[0].v;
+	}
+
+	u32 running_min(u32 win, u32 t, u32 meas)
+	{
+		const sample val = { t, meas };
+
+		if (val.v <= s[0].v || val.t - s[2].t > win)
+			return reset(t, meas);
+		if (val.v <= s[1].v)
+			s[2] = s[1] = val;
+		else if (val.v <= s[2].v)
+			s[2] = val;
+		return subwin_update(win, val);
+	}
+
+private:
+	u32 subwin_update(u32 win, const sample &val)
+	{
+		u32 dt = val.t - s[0].t;
+
+		if (dt > win) {
+			s[0] = s[1];
+			s[1] = s[2];
+			s[2] = val;
+			if (val.t - s[0].t > win) {
+				s[0] = s[1];
+				s[1] = s[2];
+				s[2] = val;
+			}
+		} else if (s[1].t == s[0].t && dt > win / 4) {
+			s[2] = s[1] = val;
+		} else if (s[2].t == s[1].t && dt > win / 2) {
+			s[2] = val;
+		}
+		return s[0].v;
+	}
+};
+
+/* The module parameters of tcp_suss.c that act on a single flow */
+struct config {
+	u32	mss = 1448;
+	bool	enabled = true;			/* suss			*/
+	int	max_jumps = 3;			/* suss_max		*/
+	int	max_jumps_cap = 5;		/* suss_max_cap		*/
+	bool	gradient = false;		/* suss_gradient	*/
+	u32	rtt_win_ms = 10000;		/* suss_rtt_win		*/
+	u32	stages = 1;			/* suss_stages		*/
+	bool	cap = true;			/* false: the transport ends slow start itself (suss_nocap) */
+	u32	cap_window = 16;		/* no cap below this cwnd (hystart_low_window)	*/
+	u32	ack_delta_us = 2000;		/* spacing of the ACKs of a train (hystart_ack_delta_us)	*/
+	u32	gso_max_size = 65536;		/* sk_gso_max_size, for the ACK delay of the cap without the gradient */
+};
+
+/* What the kernel knows when an ACK is processed */
+struct ack_sample {
+	u64	now_ns;				/* tcp_clock_cache		*/
+	u32	ack;				/* snd_una after the ACK		*/
+	u32	snd_nxt;			/* next byte to be sent		*/
+	u32	acked;				/* packets newly acknowledged	*/
+	u32	prior_inflight;			/* packets in flight before the ACK	*/
+	u32	inflight;			/* packets in flight after the ACK	*/
+	s32	rtt_us = -1;			/* RTT sample, < 0 if none	*/
+	u32	srtt_us = 0;			/* smoothed RTT (srtt_us >> 3)	*/
+	bool	ece = false;			/* ECN-Echo (CE in QUIC ACK frames)	*/
+	bool	cwnd_limited = true;		/* tcp_is_cwnd_limited()	*/
+	u32	snd_wnd = 1U << 30;		/* peer window (bytes)		*/
+	u32	left = ~0U;			/* packets left to send, ~0U if unknown	*/
+	u64	host_pacing_rate = 0;		/* sk_pacing_rate outside SUSS pacing (Bps)	*/
+};
+
+enum state : u8 {
+	ACK_CLOCKING	= 1,
+	PACING		= 2,
+	STOPPED_CAP	= 3,
+	STOPPED_DELAY	= 4,
+	REDUCED		= 9,
+	DISABLED	= 10,
+};
+
+template <unsigned BwScale = 24, unsigned SussScale = 10>
+class basic_controller {
+public:
+	static constexpr unsigned bw_scale = BwScale;
+	static constexpr u64 bw_unit = u64(1) << BwScale;
+	static constexpr unsigned suss_scale = SussScale;
+	static constexpr unsigned grad_xshift = 4;
+	static constexpr u64 grad_min_samples = 8;
+	static constexpr s64 grad_thresh = s64(1) << (SussScale - 3);
+	static constexpr u32 max_stages = 8;
+	static constexpr u32 max_jumps = 7;
+	static constexpr u32 fat_rtt = 40000;
+	static constexpr u32 init_cwnd = 10;
+	static constexpr u32 infinite_ssthresh = 0x7fffffff;
+
+	static_assert(SussScale >= grad_xshift + 3 && SussScale < 16, "SussScale out of range");
+	static_assert(BwScale < 32, "BwScale out of range");
+
+	explicit basic_controller(const config &cfg = config()) : cfg_(cfg) { }
+
+	/* tcp_suss_init(): handshake_rtt_us is 0 if unknown or if the handshake
+	 * was retransmitted. It is the RTT reference until the first sample. */
+	void start(u64 now_ns, u32 snd_una = 0, u32 handshake_rtt_us = 0)
+	{
+		u32 now = clock_us(now_ns);
+
+		num_of_jump_ = 0;
+		gf_ = 1;
+		flag_ = 0;
+		cap_ = 0;
+		is_blue_ = 0;
+		blue_cnt_ = 0;
+		r_minupdate_ = 0;
+		perv_delta_t_bat_ = 0;
+		round_no_ = 1;
+		head_seq_ = snd_una;
+		tail_seq_ = snd_una + (init_cwnd * cfg_.mss) - 1;
+		round_start_us_ = last_ack_ = now;
+		rtt_round_ = ~0U;
+		rtt_min_.reset(now, handshake_rtt_us ? handshake_rtt_us : ~0U);
+		seeded_ = handshake_rtt_us != 0;
+		red_pkts_ = 0;
+		pace_gain_ = 1 << SussScale;
+		pace_late_us_ = 0;
+		max_jumps_ = std::min<u32>(std::clamp(cfg_.max_jumps, 0, int(max_jumps)), jumps_cap());
+		grad_n_ = grad_sx_ = grad_sy_ = grad_sxx_ = grad_sxy_ = 0;
+		grad_round_ = 0;
+		blue_ce_ = 0;
+		pacing_ = false;
+		cwnd_ = init_cwnd;
+		ssthresh_ = infinite_ssthresh;
+		state_ = cfg_.enabled ? ACK_CLOCKING : DISABLED;
+	}
+
+	/* tcp_update_skb_after_send(), blocks D4 and D1. departure_ns is the time
+	 * the packet actually leaves (tcp_clock_ns() there), not the time it was
+	 * due. inflight is the number of packets in flight before this one. */
+	void on_packet_sent(u64 departure_ns, u32 segs, u32 inflight)
+	{
+		if (state_ == PACING && pacing_) {
+			if (!red_pkts_)
+				red_first_ns_ = departure_ns;
+			red_last_ns_ = departure_ns;
+			red_last_segs_ = u16(segs);
+			red_pkts_ += segs;
+		}
+		if (cwnd_ < limit_ && state_ == PACING && cwnd_ <= inflight + segs) {
+			cwnd_ += 2;
+			if (!pacing_) {
+				pacing_ = true;
+				pacing_rate_ = rate_;
+			}
+		}
+	}
+
+	/* tcp_ack(): ECE, RTT sample (tcp_suss_acked), then cong_avoid of Reno
+	 * in slow start (tcp_suss_cong_avoid and tcp_slow_start). */
+	void on_ack(const ack_sample &a)
+	{
+		srtt_us_ = a.srtt_us;
+		in_ack_event(a);
+		if (a.rtt_us >= 0 && state_ != 0 && state_ != DISABLED)
+			acked(a);
+		if (state_ == REDUCED)
+			return;
+
+		cong_avoid(a);
+		if (!a.cwnd_limited || !in_slow_start())
+			return;
+		cwnd_ = std::min(cwnd_ + a.acked, ssthresh_);
+	}
+
+	/* tcp_init_cwnd_reduction(), block C3: a loss or an ECN CWR ends SUSS;
+	 * the transport's own congestion control continues from cwnd(). */
+	void on_loss(u32 inflight)
+	{
+		if (state_ > 0 && state_ < REDUCED) {
+			if (state_ < STOPPED_CAP)
+				cwnd_ = inflight;
+			state_ = REDUCED;
+		}
+		pacing_ = false;
+	}
+
+	u32 cwnd() const { return cwnd_; }
+	u32 ssthresh() const { return ssthresh_; }
+	bool in_slow_start() const { return state_ != REDUCED && cwnd_ < ssthresh_; }
+	/* Bps while the red train is paced, 0 otherwise */
+	u64 pacing_rate() const { return pacing_ ? pacing_rate_ : 0; }
+	u64 pacing_start_ns() const { return pacing_start_ns_; }
+	u32 limit() const { return limit_; }
+	u8 state() const { return state_; }
+	u32 round() const { return round_no_; }
+	u32 jumps() const { return num_of_jump_; }
+	u32 cap() const { return flag_ ? cap_ : 0; }
+	u32 delay_min() const { return suss_delay_min(); }
+
+private:
+	static u32 clock_us(u64 ns) { return u32(ns / 1000); }
+	static bool before(u32 a, u32 b) { return s32(a - b) < 0; }
+	static bool after(u32 a, u32 b) { return before(b, a); }
+	/* x86 masks the count of a 32 bit shift */
+	static u32 shl(u32 v, u32 n) { return v << (n & 31); }
+	static u32 shr(u32 v, u32 n) { return v >> (n & 31); }
+
+	u32 jumps_cap() const { return std::clamp(cfg_.max_jumps_cap, 1, int(max_jumps)); }
+
+	void in_ack_event(const ack_sample &a)
+	{
+		bool blue = (is_blue_ == 1) || after(a.ack, head_seq_);
+		u32 cwnd;
+
+		if (after(a.ack, head_seq_))
+			blue_ce_ = 0;
+		if (!a.ece || state_ == 0 || state_ > PACING)
+			return;
+		if (blue)
+			blue_ce_++;
+
+		cwnd = a.prior_inflight;
+		if (blue && state_ == PACING && a.prior_inflight > red_pkts_)
+			cwnd = a.prior_inflight - red_pkts_;
+		cwnd = std::max(cwnd, 2U);
+
+		pacing_ = false;
+		cwnd_ = std::min(cwnd_, cwnd);
+		limit_ = cwnd_;
+		gf_ = 0;
+		cap_ = std::min(cwnd_, (1U << 14) - 1);
+		flag_ = 1;
+		state_ = STOPPED_CAP;
+	}
+
+	void acked(const ack_sample &a)
+	{
+		u32 now = clock_us(a.now_ns);
+		u32 delay = std::max<u32>(u32(a.rtt_us), 1);
+		u32 rtt_min = rtt_min_.get();
+
+		if (seeded_) {
+			seeded_ = false;
+			rtt_min = rtt_min_.reset(now, ~0U);
+		}
+		if (rtt_min_.running_min(cfg_.rtt_win_ms * 1000, now, delay) != rtt_min)
+			r_minupdate_ = round_no_;
+		if (rtt_round_ > delay)
+			rtt_round_ = delay;
+
+		if (cfg_.cap && cwnd_ < ssthresh_ && cwnd_ >= cfg_.cap_window)
+			suss_cap(a, delay);
+	}
+
+	/* Without a seed, the smoothed RTT of the transport before the first sample */
+	u32 suss_delay_min() const { return rtt_min_.get() == ~0U ? srtt_us_ : rtt_min_.get(); }
+
+	s64 delay_gradient(u32 now, u32 delay)
+	{
+		u32 x = std::min<u32>((now - round_start_us_) >> grad_xshift, 0xffff);
+		u32 y = std::min<u32>(delay - std::min(delay, suss_delay_min()), 1 << 20);
+		u64 n = grad_n_;
+		u64 den;
+		s64 num;
+
+		if (n < (1 << 12)) {
+			grad_n_ = u32(++n);
+			grad_sx_ += x;
+			grad_sy_ += y;
+			grad_sxx_ += u64(x) * x;
+			grad_sxy_ += u64(x) * y;
+		}
+		if (n < grad_min_samples)
+			return -1;
+
+		den = n * grad_sxx_ - grad_sx_ * grad_sx_;
+		den >>= SussScale - grad_xshift;
+		if (!den)
+			return -1;
+		num = s64(n * grad_sxy_) - s64(grad_sx_ * grad_sy_);
+
+		return num / s64(den);
+	}
+
+	void suss_cap(const ack_sample &a, u32 delay)
+	{
+		u32 now = clock_us(a.now_ns);
+		u32 delay_min = suss_delay_min();
+
+		if (flag_ == 1 && cwnd_ > cap_) {
+			state_ = STOPPED_CAP;
+			if (num_of_jump_ > 1)
+				cwnd_ = a.inflight;
+			ssthresh_ = cwnd_;
+			return;
+		}
+
+		/* The gradient has to pass in the blue trains of two rounds in a row */
+		if (cfg_.gradient && flag_ == 0 && state_ < STOPPED_CAP && is_blue_ != 0 &&
+		    grad_round_ != round_no_) {
+			s64 grad = delay_gradient(now, delay);
+
+			if (grad >= grad_thresh && u32(grad_round_ + 1) != round_no_) {
+				grad_round_ = u8(round_no_);
+			} else if (grad >= grad_thresh) {
+				u32 elapsed = std::max(now - round_start_us_, 1U);
+				u64 bdp = u64(blue_cnt_) * delay_min / elapsed;
+
+				grad_round_ = u8(round_no_);
+				flag_ = 1;
+				cap_ = u32(std::min<u64>(std::max<u64>(bdp, cwnd_), (1 << 14) - 1));
+			}
+		}
+
+		if (!cfg_.gradient && flag_ == 0 && state_ < STOPPED_CAP && is_blue_ != 0) {
+			if (s32(now - last_ack_) <= s32(cfg_.ack_delta_us)) {
+				u32 threshold, temp;
+
+				last_ack_ = now;
+				threshold = delay_min + ack_delay(a);
+				threshold >>= 1;
+				temp = shl(now - round_start_us_, num_of_jump_);
+				if (temp > threshold) {
+					flag_ = 1;
+					cap_ = (cwnd_ + (blue_cnt_ * ((1 << num_of_jump_) - 1))) & 0x3fff;
+				}
+			}
+		}
+	}
+
+	u32 ack_delay(const ack_sample &a) const
+	{
+		if (!a.host_pacing_rate)
+			return 0;
+		return u32(std::min<u64>(1000, u64(cfg_.gso_max_size) * 4 * 1000000 / a.host_pacing_rate));
+	}
+
+	void cong_avoid(const ack_sample &a)
+	{
+		if (state_ > PACING && state_ < DISABLED)
+			pacing_ = false;
+		if (state_ < STOPPED_CAP && (flag_ == 0 || cwnd_ < cap_))
+			measurements(a);
+	}
+
+	u8 speedup(u32 delta_t_bat)
+	{
+		u32 delay_min = suss_delay_min();
+		u8 value = 0;
+
+		if (round_no_ == 2) {
+			if (delay_min > 10000 && delta_t_bat < (delay_min >> 2)) {
+				value = 1;
+				if (delay_min < fat_rtt)
+					max_jumps_ = std::min<u32>(max_jumps_, u32(std::max(cfg_.max_jumps, 0)));
+			} else {
+				state_ = DISABLED;
+			}
+			return value;
+		}
+
+		u32 delta_t = shl(delta_t_bat, round_no_ - 2);
+		u32 perv_delta_t = shl(perv_delta_t_bat_, round_no_ - 3);
+		u64 mu = (u64(delta_t) << SussScale) / (u64(std::max<u32>(perv_delta_t, 1)) << 1);
+		u64 temp = (mu * delta_t) >> (SussScale - 1);
+
+		if ((round_no_ == max_jumps_ + 2) && (max_jumps_ < jumps_cap()) &&
+		    (delay_min >= fat_rtt) && ((temp << 1) <= delay_min))
+			max_jumps_++;
+
+		/* Condition 1 */
+		value = (temp <= delay_min) && (round_no_ < (max_jumps_ + 2));
+
+		/* Condition 2 */
+		if (value == 1) {
+			u32 k = round_no_ - r_minupdate_;
+			u64 temp1 = u64(k + 1) * rtt_round_;
+			u64 temp2 = u64(delay_min * (k + 1)) + ((delay_min * k) >> 3);
+
+			if (temp1 > temp2)
+				value = 0;
+		}
+		return value;
+	}
+
+	u32 rwnd_pkts(const ack_sample &a, u32 red_ack) const
+	{
+		u32 edge;
+
+		edge = a.ack + (red_ack * cfg_.mss) + a.snd_wnd;
+		if (!after(edge, a.snd_nxt))
+			return 0;
+		return (edge - a.snd_nxt) / cfg_.mss;
+	}
+
+	void pacing_feedback()
+	{
+		u64 real = 0, late = 0, span, gain, asked;
+
+		if (!red_pkts_)
+			return;
+		asked = rate_sum_ / std::max<u32>(stage_, 1);
+
+		if (red_first_ns_ > pacing_start_ns_)
+			late = (red_first_ns_ - pacing_start_ns_) / 1000;
+		pace_late_us_ = u32(std::min<u64>(late, ~0U));
+
+		span = red_last_ns_ - red_first_ns_;
+		if (red_pkts_ > red_last_segs_ && span) {
+			real = u64(red_pkts_ - red_last_segs_) * cfg_.mss * 1000000000ULL / span;
+			if (real) {
+				gain = (asked << SussScale) / real;
+				gain = (gain + pace_gain_) >> 1;
+				pace_gain_ = u16(std::clamp<u64>(gain, 1 << (SussScale - 1), 1 << (SussScale + 1)));
+			}
+		}
+		red_pkts_ = 0;
+	}
+
+	void pacing_stage(const ack_sample &a, u32 now)
+	{
+		u32 stages = std::clamp<u32>(cfg_.stages, 1, max_stages);
+		u32 elapsed = now - round_start_us_;
+		u64 start, end, remain_ns, deliv, need, rate;
+		u32 left, extra;
+
+		if (stage_ >= stages || !pacing_ || !elapsed)
+			return;
+
+		start = pacing_start_ns_ + u64(stage_) * stage_ns_;
+		end = pacing_start_ns_ + u64(stages) * stage_ns_;
+		if (a.now_ns < start || a.now_ns >= end)
+			return;
+		stage_++;
+
+		remain_ns = end - a.now_ns;
+		left = red_plan_ - std::min(red_pkts_, red_plan_);
+		need = u64(left) * cfg_.mss * 1000000000ULL / remain_ns;
+		deliv = u64(a.ack - round_una_) * 1000000 / elapsed;
+		rate = std::clamp<u64>(deliv, base_rate_ >> 1, base_rate_ << 1);
+
+		if (rate > need) {
+			extra = u32((rate - need) * remain_ns / (u64(cfg_.mss) * 1000000000ULL));
+			extra = std::min(extra, red_max_ - std::min(red_max_, red_plan_));
+			red_plan_ += extra;
+			limit_ += extra;
+		}
+
+		base_rate_ = rate;
+		rate_ = (rate * pace_gain_) >> SussScale;
+		rate_sum_ += rate_;
+		pacing_rate_ = rate_;
+	}
+
+	void measurements(const ack_sample &a)
+	{
+		u32 now = clock_us(a.now_ns);
+		u32 delay_min = suss_delay_min();
+
+		if (is_blue_ == 2)
+			is_blue_ = 0;
+
+		if (a.ack > head_seq_) {
+			is_blue_ = 1;
+			blue_cnt_ = 0;
+			round_no_ = (round_no_ + 1) & 0x1f;
+			round_start_us_ = now;
+			last_ack_ = now;
+			rtt_round_ = ~0U;
+			head_seq_ = a.snd_nxt;
+			round_una_ = a.ack;
+			if (state_ == PACING)
+				pacing_feedback();
+			pacing_ = false;
+			state_ = ACK_CLOCKING;
+			grad_n_ = 0;
+			grad_sx_ = grad_sy_ = grad_sxx_ = grad_sxy_ = 0;
+		}
+
+		if (a.ack > tail_seq_) {
+			u32 temp, elapsed, blue_pkt, blue_ack, red_pkt, red_ack, delta_t_bat, pacing_duration;
+			u32 plan_pkt, pace_us;
+
+			elapsed = now - round_start_us_;
+			is_blue_ = 2;
+			blue_pkt = shl(init_cwnd, round_no_ - 1);
+			blue_ack = blue_pkt >> 1;
+			tail_seq_ = head_seq_ + (blue_pkt * cfg_.mss) - 1;
+
+			temp = std::max<u32>(blue_cnt_, 1) << 1;
+			delta_t_bat = u32(s64(u64(blue_pkt * elapsed)) / temp);
+
+			if (gf_ == 1)
+				gf_ = speedup(delta_t_bat);
+			/* Kept while the growth factor is off (see tcp_suss.c) */
+			perv_delta_t_bat_ = delta_t_bat & 0x3ffff;
+
+			if (gf_ == 1) {
+				u32 left = a.left;
+				u32 headroom = cwnd_ + a.acked;
+				u32 rwnd;
+				u64 rate, guard;
+
+				/* A jump does not take cwnd beyond a cap that is set */
+				if (flag_)
+					left = std::min(left, cap_ - std::min(cap_, a.inflight));
+
+				red_pkt = shl(blue_pkt, round_no_ - 1) - blue_pkt;
+				red_ack = shl(blue_ack, round_no_ - 2) - blue_ack;
+				plan_pkt = red_pkt;
+
+				headroom -= std::min(headroom, a.inflight);
+				if (left <= headroom + (red_ack << 1))
+					red_pkt = 0;
+				else
+					red_pkt = std::min(red_pkt, left - headroom);
+
+				rwnd = rwnd_pkts(a, red_ack);
+				if (rwnd <= headroom + (red_ack << 1))
+					red_pkt = 0;
+				else
+					red_pkt = std::min(red_pkt, rwnd - headroom);
+
+				if (!red_pkt)
+					plan_pkt = 0;
+
+				red_plan_ = red_pkt;
+				red_max_ = red_pkt ? std::min({ red_pkt << 1, left - headroom, rwnd - headroom }) : 0;
+
+				limit_ = (cwnd_ + a.acked) + red_pkt - (red_ack - std::min(red_ack, plan_pkt - red_pkt));
+				pacing_duration = delay_min - shr(delay_min, round_no_ - 1);
+				pace_us = red_pkt ? u32(u64(pacing_duration) * red_pkt / plan_pkt) : 0;
+				rate = u64(s64(u64(plan_pkt * cfg_.mss) * bw_unit) / std::max<s64>(pacing_duration, 1));
+				rate *= 1000000;
+				rate = rate >> BwScale;
+				base_rate_ = rate;
+				rate = (rate * pace_gain_) >> SussScale;
+				rate_ = rate;
+
+				temp = delay_min - pacing_duration;
+				if (red_pkt && temp > delta_t_bat) {
+					state_ = PACING;
+					num_of_jump_ = (num_of_jump_ + 1) & 0x7;
+					guard = (temp - delta_t_bat) >> 1;
+					guard = (guard - std::min<u64>(guard, pace_late_us_)) * 1000;
+					pacing_start_ns_ = a.now_ns + guard;
+					red_pkts_ = 0;
+					stage_ = 1;
+					rate_sum_ = rate_;
+					stage_ns_ = u32(u64(pace_us) * 1000 /
+							std::clamp<u32>(cfg_.stages, 1, max_stages));
+				} else {
+					state_ = ACK_CLOCKING;
+				}
+			}
+		}
+
+		if (is_blue_ != 0)
+			blue_cnt_ = (blue_cnt_ + a.acked) & 0xfff;
+
+		if (is_blue_ == 0 && state_ == PACING) {
+			cwnd_ -= a.acked;
+			pacing_stage(a, now);
+		}
+	}
+
+	config	cfg_;
+	minmax	rtt_min_ = {};
+	u64	rate_ = 0;		/* suss_rate		*/
+	u32	srtt_us_ = 0;		/* srtt_us >> 3 of the last ACK	*/
+	u64	base_rate_ = 0;		/* suss_base_rate	*/
+	u64	rate_sum_ = 0;		/* suss_rate_sum	*/
+	u64	pacing_rate_ = 0;	/* sk_pacing_rate while pacing	*/
+	u64	pacing_start_ns_ = 0;
+	u64	red_first_ns_ = 0;
+	u64	red_last_ns_ = 0;
+	u64	grad_sx_ = 0, grad_sy_ = 0, grad_sxx_ = 0, grad_sxy_ = 0;
+	u32	grad_n_ = 0;
+	u32	cwnd_ = init_cwnd;
+	u32	ssthresh_ = infinite_ssthresh;
+	u32	limit_ = 0;
+	u32	head_seq_ = 0, tail_seq_ = 0;
+	u32	round_start_us_ = 0, last_ack_ = 0, round_una_ = 0;
+	u32	rtt_round_ = ~0U;
+	u32	red_pkts_ = 0, red_plan_ = 0, red_max_ = 0;
+	u32	pace_late_us_ = 0;
+	u32	stage_ns_ = 0;
+	u32	cap_ = 0;		/* 14 bits	*/
+	u32	blue_cnt_ = 0;		/* 12 bits	*/
+	u32	perv_delta_t_bat_ = 0;	/* 18 bits	*/
+	u32	round_no_ = 1;		/* 5 bits	*/
+	u32	r_minupdate_ = 0;	/* 5 bits	*/
+	u32	num_of_jump_ = 0;	/* 3 bits	*/
+	u32	max_jumps_ = 0;
+	u16	pace_gain_ = 1 << SussScale;
+	u16	red_last_segs_ = 0;
+	u16	blue_ce_ = 0;
+	u8	stage_ = 0;
+	u8	state_ = 0;
+	u8	is_blue_ = 0;		/* 2 bits	*/
+	u8	gf_ = 1;
+	u8	flag_ = 0;
+	u8	grad_round_ = 0;
+	bool	seeded_ = false;
+	bool	pacing_ = false;
+};
+
+using controller = basic_controller<>;
+
+} /* namespace suss */
+
+#endif /* SUSS_CONTROLLER_HPP */